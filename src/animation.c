@@ -0,0 +1,67 @@
+#define WOB_FILE "animation.c"
+
+#include "animation.h"
+
+double
+wob_animation_ease(enum wob_animation_curve curve, double progress)
+{
+	if (progress <= 0.0) {
+		return 0.0;
+	}
+	if (progress >= 1.0) {
+		return 1.0;
+	}
+
+	// cubic curves, close to the CSS ones and cheap enough to evaluate every frame
+	double inverse = 1.0 - progress;
+	switch (curve) {
+		case WOB_ANIMATION_CURVE_LINEAR:
+			return progress;
+		case WOB_ANIMATION_CURVE_EASE_IN:
+			return progress * progress * progress;
+		case WOB_ANIMATION_CURVE_EASE_OUT:
+			return 1.0 - inverse * inverse * inverse;
+		case WOB_ANIMATION_CURVE_EASE_IN_OUT:
+			if (progress < 0.5) {
+				return 4.0 * progress * progress * progress;
+			}
+			return 1.0 - 4.0 * inverse * inverse * inverse;
+	}
+
+	return progress;
+}
+
+void
+wob_animation_start(struct wob_animation *animation, double from, double to)
+{
+	// retargeting a running animation starts over from wherever it got to, its start time is taken from the next frame
+	animation->from = from;
+	animation->to = to;
+	animation->started = false;
+	animation->running = from != to;
+}
+
+double
+wob_animation_step(struct wob_animation *animation, enum wob_animation_curve curve, unsigned long duration_msec, uint32_t time_msec)
+{
+	if (!animation->running) {
+		return animation->to;
+	}
+
+	if (!animation->started) {
+		animation->start_msec = time_msec - WOB_ANIMATION_FIRST_STEP_MSEC;
+		animation->started = true;
+	}
+
+	// unsigned difference survives the timestamp wrapping around
+	uint32_t elapsed_msec = time_msec - animation->start_msec;
+	if (duration_msec == 0 || elapsed_msec >= duration_msec) {
+		animation->started = false;
+		animation->running = false;
+		return animation->to;
+	}
+
+	double eased = wob_animation_ease(curve, (double) elapsed_msec / (double) duration_msec);
+
+	return animation->from + (animation->to - animation->from) * eased;
+}
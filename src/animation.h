@@ -0,0 +1,31 @@
+#ifndef _WOB_ANIMATION_H
+#define _WOB_ANIMATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// time the first frame is counted as into the animation, one frame at 60 Hz, so it already shows a step instead of the start value
+#define WOB_ANIMATION_FIRST_STEP_MSEC 16
+
+// transition of the shown percentage towards the last received value, stepped by frame callbacks
+struct wob_animation {
+	double from;
+	double to;
+	// frame callback time the animation is counted from, in milliseconds with an undefined base
+	uint32_t start_msec;
+	// first step was taken, cleared again once the animation settles
+	bool started;
+	bool running;
+};
+
+// progress in interval from 0 to 1 shaped by the curve
+double wob_animation_ease(enum wob_animation_curve curve, double progress);
+
+void wob_animation_start(struct wob_animation *animation, double from, double to);
+
+// percentage to show in the frame at time_msec, animation stops running once it reaches its target
+double wob_animation_step(struct wob_animation *animation, enum wob_animation_curve curve, unsigned long duration_msec, uint32_t time_msec);
+
+#endif
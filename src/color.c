@@ -16,7 +16,7 @@ wob_color_to_argb(const struct wob_color color)
 	uint8_t green = (uint8_t) (color.g * UINT8_MAX);
 	uint8_t blue = (uint8_t) (color.b * UINT8_MAX);
 
-	return (alpha << 24) + (red << 16) + (green << 8) + blue;
+	return ((uint32_t) alpha << 24) + ((uint32_t) red << 16) + ((uint32_t) green << 8) + blue;
 }
 
 uint32_t
@@ -27,7 +27,7 @@ wob_color_to_rgba(const struct wob_color color)
 	uint8_t green = (uint8_t) (color.g * UINT8_MAX);
 	uint8_t blue = (uint8_t) (color.b * UINT8_MAX);
 
-	return (red << 24) + (green << 16) + (blue << 8) + alpha;
+	return ((uint32_t) red << 24) + ((uint32_t) green << 16) + ((uint32_t) blue << 8) + alpha;
 }
 
 struct wob_color
@@ -43,6 +43,93 @@ wob_color_premultiply_alpha(const struct wob_color color)
 	return premultiplied_color;
 }
 
+uint32_t
+wob_color_pack(const struct wob_color color, enum wob_pixel_format format)
+{
+	uint32_t pixel = wob_color_to_argb(wob_color_premultiply_alpha(color));
+	switch (format) {
+		case WOB_PIXEL_FORMAT_ARGB8888:
+			return pixel;
+		case WOB_PIXEL_FORMAT_XRGB8888:
+			// no alpha channel, translucent colors come out as if blended over black
+			return pixel | 0xFF000000;
+		case WOB_PIXEL_FORMAT_RGB565: {
+			uint32_t red = (pixel >> 16) & 0xFF;
+			uint32_t green = (pixel >> 8) & 0xFF;
+			uint32_t blue = pixel & 0xFF;
+
+			return ((red * 31 + 127) / 255) << 11 | ((green * 63 + 127) / 255) << 5 | (blue * 31 + 127) / 255;
+		}
+	}
+
+	return pixel;
+}
+
+size_t
+wob_pixel_format_bytes(enum wob_pixel_format format)
+{
+	switch (format) {
+		case WOB_PIXEL_FORMAT_ARGB8888:
+		case WOB_PIXEL_FORMAT_XRGB8888:
+			return 4;
+		case WOB_PIXEL_FORMAT_RGB565:
+			return 2;
+	}
+
+	return 4;
+}
+
+const char *
+wob_pixel_format_name(enum wob_pixel_format format)
+{
+	switch (format) {
+		case WOB_PIXEL_FORMAT_ARGB8888:
+			return "argb8888";
+		case WOB_PIXEL_FORMAT_XRGB8888:
+			return "xrgb8888";
+		case WOB_PIXEL_FORMAT_RGB565:
+			return "rgb565";
+	}
+
+	return "unknown";
+}
+
+bool
+wob_color_is_opaque(const struct wob_color color)
+{
+	return color.a >= 1.0f;
+}
+
+bool
+wob_colors_are_opaque(const struct wob_colors colors)
+{
+	return wob_color_is_opaque(colors.background) && wob_color_is_opaque(colors.border) && wob_color_is_opaque(colors.value);
+}
+
+void
+wob_colors_pack(struct wob_colors *colors)
+{
+	for (enum wob_pixel_format format = 0; format < WOB_PIXEL_FORMATS_COUNT; ++format) {
+		colors->packed[format] = (struct wob_packed_colors) {
+			.background = wob_color_pack(colors->background, format),
+			.border = wob_color_pack(colors->border, format),
+			.value = wob_color_pack(colors->value, format),
+		};
+	}
+}
+
+bool
+wob_packed_colors_eq(const struct wob_packed_colors a, const struct wob_packed_colors b)
+{
+	return a.background == b.background && a.border == b.border && a.value == b.value;
+}
+
+bool
+wob_color_eq(const struct wob_color a, const struct wob_color b)
+{
+	return a.a == b.a && a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
 int
 hex_to_int(char c)
 {
@@ -2,6 +2,7 @@
 #define _WOB_COLOR_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define WOB_COLOR_PRINTF_FORMAT "%02X%02X%02X%02X"
@@ -14,12 +15,51 @@ struct wob_color {
 	float b;
 };
 
+enum wob_pixel_format {
+	WOB_PIXEL_FORMAT_ARGB8888,
+	WOB_PIXEL_FORMAT_XRGB8888,
+	WOB_PIXEL_FORMAT_RGB565,
+};
+
+#define WOB_PIXEL_FORMATS_COUNT 3
+
+// premultiplied pixels ready to be written into a buffer of one format, 16-bit formats use the low half
+struct wob_packed_colors {
+	uint32_t background;
+	uint32_t border;
+	uint32_t value;
+};
+
+struct wob_colors {
+	struct wob_color background;
+	struct wob_color border;
+	struct wob_color value;
+	// indexed by enum wob_pixel_format, filled by wob_colors_pack()
+	struct wob_packed_colors packed[WOB_PIXEL_FORMATS_COUNT];
+};
+
 uint32_t wob_color_to_argb(struct wob_color color);
 
 uint32_t wob_color_to_rgba(struct wob_color color);
 
 struct wob_color wob_color_premultiply_alpha(struct wob_color color);
 
+uint32_t wob_color_pack(struct wob_color color, enum wob_pixel_format format);
+
+size_t wob_pixel_format_bytes(enum wob_pixel_format format);
+
+const char *wob_pixel_format_name(enum wob_pixel_format format);
+
+bool wob_color_is_opaque(struct wob_color color);
+
+bool wob_colors_are_opaque(struct wob_colors colors);
+
+void wob_colors_pack(struct wob_colors *colors);
+
+bool wob_packed_colors_eq(struct wob_packed_colors a, struct wob_packed_colors b);
+
+bool wob_color_eq(struct wob_color a, struct wob_color b);
+
 bool wob_color_from_rgba_string(const char *str, struct wob_color *color);
 
 #endif
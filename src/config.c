@@ -5,6 +5,7 @@
 
 #include <ini.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -99,6 +100,85 @@ parse_overflow_mode(const char *str, enum wob_overflow_mode *value)
 	return false;
 }
 
+bool
+parse_hide_mode(const char *str, enum wob_hide_mode *value)
+{
+	if (strcmp(str, "destroy") == 0) {
+		*value = WOB_HIDE_MODE_DESTROY;
+		return true;
+	}
+
+	if (strcmp(str, "unmap") == 0) {
+		*value = WOB_HIDE_MODE_UNMAP;
+		return true;
+	}
+
+	return false;
+}
+
+bool
+parse_animation_curve(const char *str, enum wob_animation_curve *value)
+{
+	if (strcmp(str, "linear") == 0) {
+		*value = WOB_ANIMATION_CURVE_LINEAR;
+		return true;
+	}
+
+	if (strcmp(str, "ease-in") == 0) {
+		*value = WOB_ANIMATION_CURVE_EASE_IN;
+		return true;
+	}
+
+	if (strcmp(str, "ease-out") == 0) {
+		*value = WOB_ANIMATION_CURVE_EASE_OUT;
+		return true;
+	}
+
+	if (strcmp(str, "ease-in-out") == 0) {
+		*value = WOB_ANIMATION_CURVE_EASE_IN_OUT;
+		return true;
+	}
+
+	return false;
+}
+
+bool
+parse_render_mode(const char *str, enum wob_render_mode *value)
+{
+	if (strcmp(str, "buffer") == 0) {
+		*value = WOB_RENDER_MODE_BUFFER;
+		return true;
+	}
+
+	if (strcmp(str, "subsurface") == 0) {
+		*value = WOB_RENDER_MODE_SUBSURFACE;
+		return true;
+	}
+
+	if (strcmp(str, "solid") == 0) {
+		*value = WOB_RENDER_MODE_SOLID;
+		return true;
+	}
+
+	return false;
+}
+
+bool
+parse_buffer_format(const char *str, enum wob_buffer_format *value)
+{
+	if (strcmp(str, "auto") == 0) {
+		*value = WOB_BUFFER_FORMAT_AUTO;
+		return true;
+	}
+
+	if (strcmp(str, "rgb565") == 0) {
+		*value = WOB_BUFFER_FORMAT_RGB565;
+		return true;
+	}
+
+	return false;
+}
+
 bool
 parse_number(const char *str, unsigned long *value)
 {
@@ -296,8 +376,11 @@ handler(void *user, const char *section, const char *name, const char *value)
 			return 1;
 		}
 		if (strcmp(name, "output_mode") == 0) {
-			wob_log_warn("output_mode was removed, now it always behaves as \"focused\"");
-			return 0;
+			if (parse_output_mode(value, &config->output_mode) == false) {
+				wob_log_error("Invalid argument for output_mode. Valid options are focused, all and whitelist");
+				return 0;
+			}
+			return 1;
 		}
 		if (strcmp(name, "orientation") == 0) {
 			if (parse_orientation(value, &config->dimensions.orientation) == false) {
@@ -306,6 +389,42 @@ handler(void *user, const char *section, const char *name, const char *value)
 			}
 			return 1;
 		}
+		if (strcmp(name, "render_mode") == 0) {
+			if (parse_render_mode(value, &config->render_mode) == false) {
+				wob_log_error("Invalid argument for render_mode. Valid options are buffer, subsurface and solid");
+				return 0;
+			}
+			return 1;
+		}
+		if (strcmp(name, "buffer_format") == 0) {
+			if (parse_buffer_format(value, &config->buffer_format) == false) {
+				wob_log_error("Invalid argument for buffer_format. Valid options are auto and rgb565");
+				return 0;
+			}
+			return 1;
+		}
+		if (strcmp(name, "hide_mode") == 0) {
+			if (parse_hide_mode(value, &config->hide_mode) == false) {
+				wob_log_error("Invalid argument for hide_mode. Valid options are destroy and unmap");
+				return 0;
+			}
+			return 1;
+		}
+		if (strcmp(name, "animation_duration") == 0) {
+			if (parse_number(value, &ul) == false || ul > 10000) {
+				wob_log_error("Animation duration must be a value between 0 and %lu.", 10000);
+				return 0;
+			}
+			config->animation_duration_msec = ul;
+			return 1;
+		}
+		if (strcmp(name, "animation_curve") == 0) {
+			if (parse_animation_curve(value, &config->animation_curve) == false) {
+				wob_log_error("Invalid argument for animation_curve. Valid options are linear, ease-in, ease-out and ease-in-out");
+				return 0;
+			}
+			return 1;
+		}
 
 		wob_log_warn("Unknown config key %s", name);
 		return 1;
@@ -394,6 +513,41 @@ handler(void *user, const char *section, const char *name, const char *value)
 		return 1;
 	}
 
+	if (strncmp(section, "source.", sizeof("source.") - 1) == 0) {
+		char source_id[INI_MAX_LINE + 1] = {0};
+		strncpy(source_id, section + sizeof("source.") - 1, INI_MAX_LINE);
+
+		struct wob_source_config *source_config = wob_config_find_source(config, source_id);
+		if (source_config == NULL) {
+			source_config = calloc(1, sizeof(struct wob_source_config));
+			if (source_config == NULL) {
+				wob_log_panic("calloc() failed");
+			}
+
+			source_config->id = strdup(source_id);
+			wl_list_insert(&config->sources, &source_config->link);
+		}
+
+		if (strcmp(name, "path") == 0) {
+			free(source_config->path);
+			source_config->path = strdup(value);
+			return 1;
+		}
+		if (strcmp(name, "max_path") == 0) {
+			free(source_config->max_path);
+			source_config->max_path = strdup(value);
+			return 1;
+		}
+		if (strcmp(name, "style") == 0) {
+			free(source_config->style_name);
+			source_config->style_name = strdup(value);
+			return 1;
+		}
+
+		wob_log_warn("Unknown config key %s", name);
+		return 1;
+	}
+
 	if (strncmp(section, "style.", sizeof("style.") - 1) == 0) {
 		char style_name[INI_MAX_LINE + 1] = {0};
 		strncpy(style_name, section + sizeof("style.") - 1, INI_MAX_LINE);
@@ -499,6 +653,9 @@ wob_config_create()
 
 	wl_list_init(&config->outputs);
 	wl_list_init(&config->styles);
+	wl_list_init(&config->sources);
+	config->styles_index = (struct wob_name_index) {0};
+	config->outputs_index = (struct wob_name_index) {0};
 
 	config->sandbox = true;
 	config->max = 100;
@@ -512,16 +669,81 @@ wob_config_create()
 	config->margin = (struct wob_margin) {.top = 0, .left = 0, .bottom = 0, .right = 0};
 	config->anchor = WOB_ANCHOR_CENTER;
 	config->overflow_mode = WOB_OVERFLOW_MODE_WRAP;
+	config->output_mode = WOB_OUTPUT_MODE_FOCUSED;
+	config->render_mode = WOB_RENDER_MODE_BUFFER;
+	config->hide_mode = WOB_HIDE_MODE_DESTROY;
+	config->buffer_format = WOB_BUFFER_FORMAT_AUTO;
+	config->animation_duration_msec = 0;
+	config->animation_curve = WOB_ANIMATION_CURVE_EASE_OUT;
+	config->opaque = true;
 	config->default_style.colors.background = (struct wob_color) {.a = 1.0f, .r = 0.0f, .g = 0.0f, .b = 0.0f};
 	config->default_style.colors.value = (struct wob_color) {.a = 1.0f, .r = 1.0f, .g = 1.0f, .b = 1.0f};
 	config->default_style.colors.border = (struct wob_color) {.a = 1.0f, .r = 1.0f, .g = 1.0f, .b = 1.0f};
 	config->default_style.overflow_colors.background = (struct wob_color) {.a = 1.0f, .r = 0.0f, .g = 0.0f, .b = 0.0f};
 	config->default_style.overflow_colors.value = (struct wob_color) {.a = 1.0f, .r = 1.0f, .g = 0.0f, .b = 0.0f};
 	config->default_style.overflow_colors.border = (struct wob_color) {.a = 1.0f, .r = 1.0f, .g = 1.0f, .b = 1.0f};
+	config->default_style.value = 0;
+	wob_colors_pack(&config->default_style.colors);
+	wob_colors_pack(&config->default_style.overflow_colors);
 
 	return config;
 }
 
+uint32_t
+hash_name(const char *name)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (const char *c = name; *c != '\0'; ++c) {
+		hash ^= (uint8_t) *c;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+void
+name_index_init(struct wob_name_index *index, size_t count)
+{
+	// at most half full, so probe sequences stay short
+	size_t size = 2;
+	while (size < 2 * count) {
+		size *= 2;
+	}
+
+	free(index->entries);
+	index->entries = calloc(size, sizeof(struct wob_name_index_entry));
+	if (index->entries == NULL) {
+		wob_log_panic("calloc() failed");
+	}
+	index->mask = size - 1;
+}
+
+void
+name_index_insert(struct wob_name_index *index, const char *name, void *value)
+{
+	uint32_t hash = hash_name(name);
+	size_t i = hash & index->mask;
+	while (index->entries[i].name != NULL) {
+		i = (i + 1) & index->mask;
+	}
+
+	index->entries[i] = (struct wob_name_index_entry) {.hash = hash, .name = name, .value = value};
+}
+
+void *
+name_index_find(const struct wob_name_index *index, const char *name)
+{
+	uint32_t hash = hash_name(name);
+	for (size_t i = hash & index->mask; index->entries[i].name != NULL; i = (i + 1) & index->mask) {
+		if (index->entries[i].hash == hash && strcmp(index->entries[i].name, name) == 0) {
+			return index->entries[i].value;
+		}
+	}
+
+	return NULL;
+}
+
 bool
 wob_config_load(struct wob_config *config, const char *config_path)
 {
@@ -558,12 +780,82 @@ wob_config_load(struct wob_config *config, const char *config_path)
 		}
 	}
 
+	// styles can be defined after the sources using them
+	struct wob_source_config *source;
+	wl_list_for_each (source, &config->sources, link) {
+		if (source->path == NULL) {
+			wob_log_error("Source %s is missing \"path\" property", source->id);
+			return false;
+		}
+
+		source->style = &config->default_style;
+		if (source->style_name != NULL) {
+			source->style = wob_config_find_style(config, source->style_name);
+			if (source->style == NULL) {
+				wob_log_error("Source %s uses undefined style %s", source->id, source->style_name);
+				return false;
+			}
+		}
+	}
+
+	// colors are final now, pixels are packed once instead of on every frame
+	wob_colors_pack(&config->default_style.colors);
+	wob_colors_pack(&config->default_style.overflow_colors);
+	config->opaque = wob_colors_are_opaque(config->default_style.colors) && wob_colors_are_opaque(config->default_style.overflow_colors);
+	struct wob_style *style;
+	wl_list_for_each (style, &config->styles, link) {
+		wob_colors_pack(&style->colors);
+		wob_colors_pack(&style->overflow_colors);
+		config->opaque = config->opaque && wob_colors_are_opaque(style->colors) && wob_colors_are_opaque(style->overflow_colors);
+	}
+
+	if (config->buffer_format == WOB_BUFFER_FORMAT_RGB565 && !config->opaque) {
+		wob_log_warn("rgb565 buffers have no alpha channel, translucent colors will be blended over black");
+	}
+
+	// names are unique by now, lookups on every input line go through the index
+	name_index_init(&config->styles_index, wl_list_length(&config->styles));
+	wl_list_for_each (style, &config->styles, link) {
+		name_index_insert(&config->styles_index, style->name, style);
+	}
+
+	name_index_init(&config->outputs_index, wl_list_length(&config->outputs));
+	wl_list_for_each (output, &config->outputs, link) {
+		name_index_insert(&config->outputs_index, output->id, output);
+	}
+
 	return true;
 }
 
+void
+debug_color(const char *prefix, const char *name, struct wob_color color)
+{
+	wob_log_debug(
+		"%s.%s = " WOB_COLOR_PRINTF_FORMAT " (argb8888 = %08lX, xrgb8888 = %08lX, rgb565 = %04lX)",
+		prefix,
+		name,
+		WOB_COLOR_PRINTF_RGBA(color),
+		(unsigned long) wob_color_pack(color, WOB_PIXEL_FORMAT_ARGB8888),
+		(unsigned long) wob_color_pack(color, WOB_PIXEL_FORMAT_XRGB8888),
+		(unsigned long) wob_color_pack(color, WOB_PIXEL_FORMAT_RGB565)
+	);
+}
+
+void
+debug_colors(const char *prefix, struct wob_colors colors)
+{
+	debug_color(prefix, "background", colors.background);
+	debug_color(prefix, "value", colors.value);
+	debug_color(prefix, "border", colors.border);
+}
+
 void
 wob_config_debug(struct wob_config *config)
 {
+	if (!wob_log_enabled(WOB_LOG_DEBUG)) {
+		return;
+	}
+
 	wob_log_debug("config.max = %lu", config->max);
 	wob_log_debug("config.timeout_msec = %lu", config->timeout_msec);
 	wob_log_debug("config.dimensions.width = %lu", config->dimensions.width);
@@ -578,22 +870,31 @@ wob_config_debug(struct wob_config *config)
 	wob_log_debug("config.margin.left = %lu", config->margin.left);
 	wob_log_debug("config.anchor = %lu (top = %d, bottom = %d, left = %d, right = %d)", config->anchor, WOB_ANCHOR_TOP, WOB_ANCHOR_BOTTOM, WOB_ANCHOR_LEFT, WOB_ANCHOR_RIGHT);
 	wob_log_debug("config.overflow_mode = %lu (wrap = %d, nowrap = %d)", config->overflow_mode, WOB_OVERFLOW_MODE_WRAP, WOB_OVERFLOW_MODE_NOWRAP);
-
-	wob_log_debug("config.colors.background = " WOB_COLOR_PRINTF_FORMAT, WOB_COLOR_PRINTF_RGBA(config->default_style.colors.background));
-	wob_log_debug("config.colors.value = " WOB_COLOR_PRINTF_FORMAT, WOB_COLOR_PRINTF_RGBA(config->default_style.colors.value));
-	wob_log_debug("config.colors.border = " WOB_COLOR_PRINTF_FORMAT, WOB_COLOR_PRINTF_RGBA(config->default_style.colors.border));
-	wob_log_debug("config.overflow_colors.background = " WOB_COLOR_PRINTF_FORMAT, WOB_COLOR_PRINTF_RGBA(config->default_style.overflow_colors.background));
-	wob_log_debug("config.overflow_colors.value = " WOB_COLOR_PRINTF_FORMAT, WOB_COLOR_PRINTF_RGBA(config->default_style.overflow_colors.value));
-	wob_log_debug("config.overflow_colors.border = " WOB_COLOR_PRINTF_FORMAT, WOB_COLOR_PRINTF_RGBA(config->default_style.overflow_colors.border));
+	wob_log_debug("config.output_mode = %lu (whitelist = %d, all = %d, focused = %d)", config->output_mode, WOB_OUTPUT_MODE_WHITELIST, WOB_OUTPUT_MODE_ALL, WOB_OUTPUT_MODE_FOCUSED);
+	wob_log_debug("config.render_mode = %lu (buffer = %d, subsurface = %d, solid = %d)", config->render_mode, WOB_RENDER_MODE_BUFFER, WOB_RENDER_MODE_SUBSURFACE, WOB_RENDER_MODE_SOLID);
+	wob_log_debug("config.hide_mode = %lu (destroy = %d, unmap = %d)", config->hide_mode, WOB_HIDE_MODE_DESTROY, WOB_HIDE_MODE_UNMAP);
+	wob_log_debug("config.buffer_format = %lu (auto = %d, rgb565 = %d)", config->buffer_format, WOB_BUFFER_FORMAT_AUTO, WOB_BUFFER_FORMAT_RGB565);
+	wob_log_debug("config.animation_duration_msec = %lu", config->animation_duration_msec);
+	wob_log_debug(
+		"config.animation_curve = %lu (linear = %d, ease-in = %d, ease-out = %d, ease-in-out = %d)",
+		config->animation_curve,
+		WOB_ANIMATION_CURVE_LINEAR,
+		WOB_ANIMATION_CURVE_EASE_IN,
+		WOB_ANIMATION_CURVE_EASE_OUT,
+		WOB_ANIMATION_CURVE_EASE_IN_OUT
+	);
+	wob_log_debug("config.opaque = %d", config->opaque);
+
+	debug_colors("config.colors", config->default_style.colors);
+	debug_colors("config.overflow_colors", config->default_style.overflow_colors);
 
 	struct wob_style *style;
 	wl_list_for_each (style, &config->styles, link) {
-		wob_log_debug("config.style.%s.colors.background = " WOB_COLOR_PRINTF_FORMAT, style->name, WOB_COLOR_PRINTF_RGBA(style->colors.background));
-		wob_log_debug("config.style.%s.colors.value = " WOB_COLOR_PRINTF_FORMAT, style->name, WOB_COLOR_PRINTF_RGBA(style->colors.value));
-		wob_log_debug("config.style.%s.colors.border = " WOB_COLOR_PRINTF_FORMAT, style->name, WOB_COLOR_PRINTF_RGBA(style->colors.border));
-		wob_log_debug("config.style.%s.overflow_colors.background = " WOB_COLOR_PRINTF_FORMAT, style->name, WOB_COLOR_PRINTF_RGBA(style->overflow_colors.background));
-		wob_log_debug("config.style.%s.overflow_colors.value = " WOB_COLOR_PRINTF_FORMAT, style->name, WOB_COLOR_PRINTF_RGBA(style->overflow_colors.value));
-		wob_log_debug("config.style.%s.overflow_colors.border = " WOB_COLOR_PRINTF_FORMAT, style->name, WOB_COLOR_PRINTF_RGBA(style->overflow_colors.border));
+		char prefix[256];
+		snprintf(prefix, sizeof(prefix), "config.style.%s.colors", style->name);
+		debug_colors(prefix, style->colors);
+		snprintf(prefix, sizeof(prefix), "config.style.%s.overflow_colors", style->name);
+		debug_colors(prefix, style->overflow_colors);
 	}
 
 	struct wob_output_config *output_config;
@@ -616,6 +917,13 @@ wob_config_debug(struct wob_config *config)
 			WOB_ORIENTATION_VERTICAL
 		);
 	}
+
+	struct wob_source_config *source_config;
+	wl_list_for_each (source_config, &config->sources, link) {
+		wob_log_debug("config.source.%s.path = %s", source_config->id, source_config->path);
+		wob_log_debug("config.source.%s.max_path = %s", source_config->id, source_config->max_path != NULL ? source_config->max_path : "<empty>");
+		wob_log_debug("config.source.%s.style = %s", source_config->id, source_config->style_name != NULL ? source_config->style_name : "<empty>");
+	}
 }
 
 void
@@ -634,67 +942,80 @@ wob_config_destroy(struct wob_config *config)
 		free(style);
 	}
 
+	struct wob_source_config *source, *source_tmp;
+	wl_list_for_each_safe (source, source_tmp, &config->sources, link) {
+		free(source->id);
+		free(source->path);
+		free(source->max_path);
+		free(source->style_name);
+		free(source);
+	}
+
+	free(config->styles_index.entries);
+	free(config->outputs_index.entries);
 	free(config);
 }
 
 struct wob_style *
 wob_config_find_style(struct wob_config *config, const char *style_name)
 {
-	struct wob_style *style = NULL;
-	bool style_found = false;
+	if (config->styles_index.entries != NULL) {
+		return name_index_find(&config->styles_index, style_name);
+	}
+
+	// still parsing, new styles are inserted at the head so keys of the current section are found right away
+	struct wob_style *style;
 	wl_list_for_each (style, &config->styles, link) {
 		if (strcmp(style->name, style_name) == 0) {
-			style_found = true;
-			break;
+			return style;
 		}
 	}
 
-	if (style_found) {
-		return style;
-	}
-	else {
-		return NULL;
-	}
+	return NULL;
 }
 
 struct wob_output_config *
 wob_config_find_output(struct wob_config *config, const char *output_id)
 {
-	struct wob_output_config *output_config = NULL;
-	bool output_found = false;
+	if (config->outputs_index.entries != NULL) {
+		return name_index_find(&config->outputs_index, output_id);
+	}
+
+	struct wob_output_config *output_config;
 	wl_list_for_each (output_config, &config->outputs, link) {
 		if (strcmp(output_config->id, output_id) == 0) {
-			output_found = true;
-			break;
+			return output_config;
 		}
 	}
 
-	if (output_found) {
-		return output_config;
-	}
-	else {
-		return NULL;
+	return NULL;
+}
+
+struct wob_source_config *
+wob_config_find_source(struct wob_config *config, const char *source_id)
+{
+	struct wob_source_config *source_config;
+	wl_list_for_each (source_config, &config->sources, link) {
+		if (strcmp(source_config->id, source_id) == 0) {
+			return source_config;
+		}
 	}
+
+	return NULL;
 }
 
 struct wob_output_config *
-wob_config_match_output(struct wob_config *config, const char *match)
+wob_config_match_output(struct wob_config *config, const char *name)
 {
-	struct wob_output_config *output_config = NULL;
-	bool output_found = false;
+	// substring match can't be indexed, callers cache the result per output
+	struct wob_output_config *output_config;
 	wl_list_for_each (output_config, &config->outputs, link) {
-		if (strstr(output_config->match, match) == 0) {
-			output_found = true;
-			break;
+		if (strstr(name, output_config->match) != NULL) {
+			return output_config;
 		}
 	}
 
-	if (output_found) {
-		return output_config;
-	}
-	else {
-		return NULL;
-	}
+	return NULL;
 }
 
 uint32_t
@@ -731,6 +1052,16 @@ wob_dimensions_eq(struct wob_dimensions a, struct wob_dimensions b)
 	return true;
 }
 
+bool
+wob_colors_eq(struct wob_colors a, struct wob_colors b)
+{
+	if (!wob_color_eq(a.background, b.background)) return false;
+	if (!wob_color_eq(a.border, b.border)) return false;
+	if (!wob_color_eq(a.value, b.value)) return false;
+
+	return true;
+}
+
 bool
 wob_margin_eq(struct wob_margin a, struct wob_margin b)
 {
@@ -25,6 +25,29 @@ enum wob_output_mode {
 	WOB_OUTPUT_MODE_FOCUSED,
 };
 
+enum wob_render_mode {
+	WOB_RENDER_MODE_BUFFER,
+	WOB_RENDER_MODE_SUBSURFACE,
+	WOB_RENDER_MODE_SOLID,
+};
+
+enum wob_hide_mode {
+	WOB_HIDE_MODE_DESTROY,
+	WOB_HIDE_MODE_UNMAP,
+};
+
+enum wob_buffer_format {
+	WOB_BUFFER_FORMAT_AUTO,
+	WOB_BUFFER_FORMAT_RGB565,
+};
+
+enum wob_animation_curve {
+	WOB_ANIMATION_CURVE_LINEAR,
+	WOB_ANIMATION_CURVE_EASE_IN,
+	WOB_ANIMATION_CURVE_EASE_OUT,
+	WOB_ANIMATION_CURVE_EASE_IN_OUT,
+};
+
 enum wob_orientation {
 	WOB_ORIENTATION_HORIZONTAL,
 	WOB_ORIENTATION_VERTICAL,
@@ -55,29 +78,60 @@ struct wob_output_config {
 	unsigned long anchor;
 };
 
-struct wob_colors {
-	struct wob_color background;
-	struct wob_color border;
-	struct wob_color value;
-};
-
 struct wob_style {
 	char *name;
 	struct wob_colors colors;
 	struct wob_colors overflow_colors;
+	// last value received with this style, relative inputs are applied to it
+	unsigned long value;
 	struct wl_list link;
 };
 
+struct wob_source_config {
+	char *id;
+	char *path;
+	char *max_path;
+	char *style_name;
+	// resolved once the whole config is loaded, default style when style_name is not set
+	struct wob_style *style;
+	struct wl_list link;
+};
+
+struct wob_name_index_entry {
+	uint32_t hash;
+	const char *name;
+	void *value;
+};
+
+// open addressing table over style names or output ids, built once the config is loaded and never changed after
+struct wob_name_index {
+	struct wob_name_index_entry *entries;
+	// table size minus one, size is a power of two
+	size_t mask;
+};
+
 struct wob_config {
 	unsigned long max;
 	unsigned long timeout_msec;
 	struct wob_margin margin;
 	unsigned long anchor;
 	enum wob_overflow_mode overflow_mode;
+	enum wob_output_mode output_mode;
+	enum wob_render_mode render_mode;
+	enum wob_hide_mode hide_mode;
+	enum wob_buffer_format buffer_format;
+	// value changes are animated when not zero
+	unsigned long animation_duration_msec;
+	enum wob_animation_curve animation_curve;
+	// no style uses a translucent color, buffers don't need an alpha channel
+	bool opaque;
 	struct wob_dimensions dimensions;
 	struct wob_style default_style;
 	struct wl_list styles;
 	struct wl_list outputs;
+	struct wl_list sources;
+	struct wob_name_index styles_index;
+	struct wob_name_index outputs_index;
 	bool sandbox;
 };
 
@@ -95,12 +149,16 @@ struct wob_style *wob_config_find_style(struct wob_config *config, const char *s
 
 struct wob_output_config *wob_config_find_output(struct wob_config *config, const char *output_id);
 
-struct wob_output_config *wob_config_match_output(struct wob_config *config, const char *match);
+struct wob_source_config *wob_config_find_source(struct wob_config *config, const char *source_id);
+
+struct wob_output_config *wob_config_match_output(struct wob_config *config, const char *name);
 
 struct wob_dimensions wob_dimensions_apply_scale(struct wob_dimensions dimensions, uint32_t scale);
 
 bool wob_dimensions_eq(struct wob_dimensions a, struct wob_dimensions b);
 
+bool wob_colors_eq(struct wob_colors a, struct wob_colors b);
+
 bool wob_margin_eq(struct wob_margin a, struct wob_margin b);
 
 #endif
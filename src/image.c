@@ -1,63 +1,313 @@
 #define WOB_FILE "image.c"
 
+#include "global_configuration.h"
 #include "image.h"
 
+#ifdef WOB_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+struct span {
+	size_t length;
+	uint32_t color;
+};
+
+typedef void (*fill_row_func)(uint32_t *pixels, size_t width, uint32_t color);
+
+void
+fill_row_scalar(uint32_t *pixels, size_t width, uint32_t color)
+{
+	for (size_t x = 0; x < width; ++x) {
+		pixels[x] = color;
+	}
+}
+
+#ifdef WOB_HAVE_X86_SIMD
+__attribute__((target("sse2"))) void
+fill_row_sse2(uint32_t *pixels, size_t width, uint32_t color)
+{
+	__m128i value = _mm_set1_epi32((int) color);
+
+	size_t x = 0;
+	for (; x + 4 <= width; x += 4) {
+		_mm_storeu_si128((__m128i *) (pixels + x), value);
+	}
+	for (; x < width; ++x) {
+		pixels[x] = color;
+	}
+}
+
+__attribute__((target("avx2"))) void
+fill_row_avx2(uint32_t *pixels, size_t width, uint32_t color)
+{
+	__m256i value = _mm256_set1_epi32((int) color);
+
+	size_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		_mm256_storeu_si256((__m256i *) (pixels + x), value);
+		_mm256_storeu_si256((__m256i *) (pixels + x + 8), value);
+	}
+	for (; x + 8 <= width; x += 8) {
+		_mm256_storeu_si256((__m256i *) (pixels + x), value);
+	}
+	for (; x < width; ++x) {
+		pixels[x] = color;
+	}
+}
+#endif
+
+fill_row_func
+select_fill_row(void)
+{
+#ifdef WOB_HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return fill_row_avx2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return fill_row_sse2;
+	}
+#endif
+
+	return fill_row_scalar;
+}
+
+void
+fill_row(uint32_t *pixels, size_t width, uint32_t color)
+{
+	static fill_row_func func = NULL;
+	if (func == NULL) {
+		func = select_fill_row();
+	}
+
+	func(pixels, width, color);
+}
+
+void
+fill_row_16(uint16_t *pixels, size_t width, uint16_t color)
+{
+	// two pixels per 32-bit store, so the same kernels do the work once the row is aligned
+	if (width > 0 && ((uintptr_t) pixels & 3) != 0) {
+		*pixels++ = color;
+		width -= 1;
+	}
+
+	fill_row((uint32_t *) pixels, width / 2, (uint32_t) color << 16 | color);
+	if (width % 2 != 0) {
+		pixels[width - 1] = color;
+	}
+}
+
+void
+fill_pixels(unsigned char *pixels, size_t width, size_t bytes_per_pixel, uint32_t color)
+{
+	if (bytes_per_pixel == 2) {
+		fill_row_16((uint16_t *) pixels, width, (uint16_t) color);
+	}
+	else {
+		fill_row((uint32_t *) pixels, width, color);
+	}
+}
+
 void
-fill_rectangle(uint32_t *pixels, size_t width, size_t height, size_t stride, uint32_t color)
+fill_rectangle(unsigned char *pixels, size_t width, size_t height, size_t stride, size_t bytes_per_pixel, uint32_t color)
 {
 	for (size_t y = 0; y < height; ++y) {
-		for (size_t x = 0; x < width; ++x) {
-			pixels[x] = color;
-		}
+		fill_pixels(pixels, width, bytes_per_pixel, color);
 		pixels += stride;
 	}
 }
 
 void
-wob_image_draw(uint32_t *image_data, struct wob_dimensions dimensions, struct wob_colors colors, double percentage)
+fill_spans(unsigned char *pixels, size_t bytes_per_pixel, const struct span *spans, size_t spans_count)
 {
-	uint32_t bar_color = wob_color_to_argb(wob_color_premultiply_alpha(colors.value));
-	uint32_t background_color = wob_color_to_argb(wob_color_premultiply_alpha(colors.background));
-	uint32_t border_color = wob_color_to_argb(wob_color_premultiply_alpha(colors.border));
+	for (size_t i = 0; i < spans_count; ++i) {
+		if (spans[i].length > 0) {
+			fill_pixels(pixels, spans[i].length, bytes_per_pixel, spans[i].color);
+			pixels += spans[i].length * bytes_per_pixel;
+		}
+	}
+}
 
-	uint32_t *data;
-	uint32_t height;
-	uint32_t width;
-	uint32_t offset;
-	uint32_t stride = dimensions.width;
+void
+wob_image_draw(void *image_data, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors, double percentage)
+{
+	size_t bytes_per_pixel = wob_pixel_format_bytes(format);
+	uint32_t bar_color = colors.value;
+	uint32_t background_color = colors.background;
+	uint32_t border_color = colors.border;
 
-	height = dimensions.height;
-	width = dimensions.width;
-	data = image_data;
-	fill_rectangle(data, width, height, stride, background_color);
+	size_t width = dimensions.width;
+	size_t height = dimensions.height;
+	size_t border_start = dimensions.border_offset;
+	size_t inner_start = dimensions.border_offset + dimensions.border_size;
+	size_t inner_width = width - 2 * inner_start;
 
-	offset = dimensions.border_offset;
-	height = dimensions.height - (2 * offset);
-	width = dimensions.width - (2 * offset);
-	data = image_data + (offset * (dimensions.width + 1));
-	fill_rectangle(data, width, height, stride, border_color);
+	struct wob_image_rect bar = wob_image_bar_delta(dimensions, 0, wob_image_bar_length(dimensions, percentage));
 
-	offset = dimensions.border_offset + dimensions.border_size;
-	height = dimensions.height - (2 * offset);
-	width = dimensions.width - (2 * offset);
-	data = image_data + (offset * (dimensions.width + 1));
-	fill_rectangle(data, width, height, stride, background_color);
+	// every row is split into horizontal spans, so each pixel is written exactly once
+	for (size_t y = 0; y < height; ++y) {
+		unsigned char *row = (unsigned char *) image_data + y * width * bytes_per_pixel;
+
+		if (y < border_start || y >= height - border_start) {
+			fill_pixels(row, width, bytes_per_pixel, background_color);
+		}
+		else if (y < inner_start || y >= height - inner_start) {
+			struct span spans[] = {
+				{border_start, background_color},
+				{width - 2 * border_start, border_color},
+				{border_start, background_color},
+			};
+			fill_spans(row, bytes_per_pixel, spans, sizeof(spans) / sizeof(spans[0]));
+		}
+		else if (y < bar.y || y >= bar.y + bar.height || bar.width == 0) {
+			struct span spans[] = {
+				{border_start, background_color},
+				{dimensions.border_size, border_color},
+				{inner_width, background_color},
+				{dimensions.border_size, border_color},
+				{border_start, background_color},
+			};
+			fill_spans(row, bytes_per_pixel, spans, sizeof(spans) / sizeof(spans[0]));
+		}
+		else {
+			struct span spans[] = {
+				{border_start, background_color},
+				{dimensions.border_size, border_color},
+				{bar.x - inner_start, background_color},
+				{bar.width, bar_color},
+				{inner_width - (bar.x - inner_start) - bar.width, background_color},
+				{dimensions.border_size, border_color},
+				{border_start, background_color},
+			};
+			fill_spans(row, bytes_per_pixel, spans, sizeof(spans) / sizeof(spans[0]));
+		}
+	}
+}
+
+void
+wob_image_fill(void *image_data, size_t width, size_t height, enum wob_pixel_format format, uint32_t pixel)
+{
+	size_t bytes_per_pixel = wob_pixel_format_bytes(format);
+	fill_rectangle(image_data, width, height, width * bytes_per_pixel, bytes_per_pixel, pixel);
+}
+
+size_t
+wob_image_bar_length(struct wob_dimensions dimensions, double percentage)
+{
+	size_t offset = dimensions.border_offset + dimensions.border_size + dimensions.bar_padding;
+	switch (dimensions.orientation) {
+		case WOB_ORIENTATION_HORIZONTAL:
+			return (dimensions.width - 2 * offset) * percentage;
+		case WOB_ORIENTATION_VERTICAL:
+			return (dimensions.height - 2 * offset) * percentage;
+	}
+
+	return 0;
+}
 
-	offset = dimensions.border_offset + dimensions.border_size + dimensions.bar_padding;
+struct wob_image_rect
+wob_image_bar_delta(struct wob_dimensions dimensions, size_t from_length, size_t to_length)
+{
+	size_t offset = dimensions.border_offset + dimensions.border_size + dimensions.bar_padding;
 	size_t bar_width = dimensions.width - 2 * offset;
 	size_t bar_height = dimensions.height - 2 * offset;
+
+	size_t shorter = from_length < to_length ? from_length : to_length;
+	size_t longer = from_length < to_length ? to_length : from_length;
+
+	struct wob_image_rect rect = {0};
 	switch (dimensions.orientation) {
 		case WOB_ORIENTATION_HORIZONTAL:
-			height = bar_height;
-			width = bar_width * percentage;
-			data = image_data + (offset * (dimensions.width + 1));
-			fill_rectangle(data, width, height, stride, bar_color);
+			rect.x = offset + shorter;
+			rect.y = offset;
+			rect.width = longer - shorter;
+			rect.height = bar_height;
 			break;
 		case WOB_ORIENTATION_VERTICAL:
-			height = bar_height * percentage;
-			width = bar_width;
-			data = image_data + (offset * (dimensions.width + 1)) + (bar_height - height) * dimensions.width;
-			fill_rectangle(data, width, height, stride, bar_color);
+			// bar grows from the bottom
+			rect.x = offset;
+			rect.y = offset + bar_height - longer;
+			rect.width = bar_width;
+			rect.height = longer - shorter;
 			break;
 	}
+
+	return rect;
+}
+
+bool
+wob_image_rect_eq(struct wob_image_rect a, struct wob_image_rect b)
+{
+	return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+void
+wob_image_layout(struct wob_dimensions dimensions, size_t bar_length, struct wob_image_part parts[WOB_IMAGE_PARTS_COUNT])
+{
+	size_t width = dimensions.width;
+	size_t height = dimensions.height;
+	size_t border_start = dimensions.border_offset;
+	size_t inner_start = dimensions.border_offset + dimensions.border_size;
+	size_t bar_start = dimensions.border_offset + dimensions.border_size + dimensions.bar_padding;
+	size_t padding = dimensions.bar_padding;
+
+	struct wob_image_rect bar = wob_image_bar_delta(dimensions, 0, bar_length);
+
+	// rectangles don't overlap, so translucent colors look the same as in wob_image_draw()
+	// parts 11 (rest of the inner background) and 12 (bar) are the only ones that depend on the value
+	struct wob_image_rect rects[WOB_IMAGE_PARTS_COUNT] = {
+		{0, 0, width, border_start},
+		{0, height - border_start, width, border_start},
+		{0, border_start, border_start, height - 2 * border_start},
+		{width - border_start, border_start, border_start, height - 2 * border_start},
+
+		{border_start, border_start, width - 2 * border_start, dimensions.border_size},
+		{border_start, height - inner_start, width - 2 * border_start, dimensions.border_size},
+		{border_start, inner_start, dimensions.border_size, height - 2 * inner_start},
+		{width - inner_start, inner_start, dimensions.border_size, height - 2 * inner_start},
+	};
+
+	switch (dimensions.orientation) {
+		case WOB_ORIENTATION_HORIZONTAL:
+			rects[8] = (struct wob_image_rect) {inner_start, inner_start, width - 2 * inner_start, padding};
+			rects[9] = (struct wob_image_rect) {inner_start, height - bar_start, width - 2 * inner_start, padding};
+			rects[10] = (struct wob_image_rect) {inner_start, bar_start, padding, height - 2 * bar_start};
+			rects[11] = (struct wob_image_rect) {bar.x + bar.width, bar_start, width - inner_start - bar.x - bar.width, height - 2 * bar_start};
+			break;
+		case WOB_ORIENTATION_VERTICAL:
+			rects[8] = (struct wob_image_rect) {inner_start, inner_start, padding, height - 2 * inner_start};
+			rects[9] = (struct wob_image_rect) {width - bar_start, inner_start, padding, height - 2 * inner_start};
+			rects[10] = (struct wob_image_rect) {bar_start, height - bar_start, width - 2 * bar_start, padding};
+			rects[11] = (struct wob_image_rect) {bar_start, inner_start, width - 2 * bar_start, bar.y - inner_start};
+			break;
+	}
+	rects[12] = bar;
+
+	for (size_t i = 0; i < WOB_IMAGE_PARTS_COUNT; ++i) {
+		parts[i].rect = rects[i];
+		if (i >= 4 && i < 8) {
+			parts[i].color = WOB_IMAGE_COLOR_BORDER;
+		}
+		else if (i == 12) {
+			parts[i].color = WOB_IMAGE_COLOR_VALUE;
+		}
+		else {
+			parts[i].color = WOB_IMAGE_COLOR_BACKGROUND;
+		}
+	}
+}
+
+struct wob_image_rect
+wob_image_draw_bar_delta(void *image_data, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors, size_t from_length, size_t to_length)
+{
+	struct wob_image_rect rect = wob_image_bar_delta(dimensions, from_length, to_length);
+
+	// strip between the old and the new end of the bar is either filled in or cleared to background
+	uint32_t color = to_length > from_length ? colors.value : colors.background;
+	size_t bytes_per_pixel = wob_pixel_format_bytes(format);
+	unsigned char *data = (unsigned char *) image_data + (rect.y * dimensions.width + rect.x) * bytes_per_pixel;
+	fill_rectangle(data, rect.width, rect.height, dimensions.width * bytes_per_pixel, bytes_per_pixel, color);
+
+	return rect;
 }
@@ -6,6 +6,39 @@
 
 #include "config.h"
 
-void wob_image_draw(uint32_t *data, struct wob_dimensions dimensions, struct wob_colors colors, double percentage);
+// outer background ring, border ring, inner background and the bar
+#define WOB_IMAGE_PARTS_COUNT 13
+
+struct wob_image_rect {
+	size_t x;
+	size_t y;
+	size_t width;
+	size_t height;
+};
+
+enum wob_image_color {
+	WOB_IMAGE_COLOR_BACKGROUND,
+	WOB_IMAGE_COLOR_BORDER,
+	WOB_IMAGE_COLOR_VALUE,
+};
+
+struct wob_image_part {
+	struct wob_image_rect rect;
+	enum wob_image_color color;
+};
+
+void wob_image_draw(void *data, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors, double percentage);
+
+void wob_image_fill(void *data, size_t width, size_t height, enum wob_pixel_format format, uint32_t pixel);
+
+size_t wob_image_bar_length(struct wob_dimensions dimensions, double percentage);
+
+struct wob_image_rect wob_image_bar_delta(struct wob_dimensions dimensions, size_t from_length, size_t to_length);
+
+bool wob_image_rect_eq(struct wob_image_rect a, struct wob_image_rect b);
+
+void wob_image_layout(struct wob_dimensions dimensions, size_t bar_length, struct wob_image_part parts[WOB_IMAGE_PARTS_COUNT]);
+
+struct wob_image_rect wob_image_draw_bar_delta(void *data, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors, size_t from_length, size_t to_length);
 
 #endif
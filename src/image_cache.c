@@ -0,0 +1,77 @@
+#define WOB_FILE "image_cache.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "image.h"
+#include "image_cache.h"
+#include "log.h"
+
+void
+wob_image_cache_init(struct wob_image_cache *cache)
+{
+	*cache = (struct wob_image_cache) {0};
+}
+
+const void *
+wob_image_cache_get(struct wob_image_cache *cache, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors)
+{
+	cache->clock += 1;
+
+	// few entries, a linear scan is cheaper than hashing the key
+	struct wob_image_cache_entry *victim = &cache->entries[0];
+	for (size_t i = 0; i < WOB_IMAGE_CACHE_SIZE; ++i) {
+		struct wob_image_cache_entry *entry = &cache->entries[i];
+		if (entry->used != 0 && entry->format == format && wob_dimensions_eq(entry->dimensions, dimensions) && wob_packed_colors_eq(entry->colors, colors)) {
+			entry->used = cache->clock;
+			cache->hits += 1;
+			return entry->chrome;
+		}
+
+		if (entry->used < victim->used) {
+			victim = entry;
+		}
+	}
+
+	cache->misses += 1;
+
+	size_t size = dimensions.width * dimensions.height * wob_pixel_format_bytes(format);
+	if (victim->used == 0 || wob_pixel_format_bytes(victim->format) != wob_pixel_format_bytes(format) || !wob_dimensions_eq(victim->dimensions, dimensions)) {
+		free(victim->chrome);
+		victim->chrome = malloc(size);
+		if (victim->chrome == NULL) {
+			wob_log_panic("malloc failed");
+		}
+	}
+
+	wob_image_draw(victim->chrome, dimensions, format, colors, 0);
+	victim->dimensions = dimensions;
+	victim->format = format;
+	victim->colors = colors;
+	victim->used = cache->clock;
+
+	wob_log_debug("cached %s chrome %lu x %lu, %lu hits and %lu misses so far", wob_pixel_format_name(format), dimensions.width, dimensions.height, cache->hits, cache->misses);
+
+	return victim->chrome;
+}
+
+void
+wob_image_cache_draw(struct wob_image_cache *cache, void *data, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors, size_t bar_length)
+{
+	const void *chrome = wob_image_cache_get(cache, dimensions, format, colors);
+	memcpy(data, chrome, dimensions.width * dimensions.height * wob_pixel_format_bytes(format));
+
+	if (bar_length > 0) {
+		wob_image_draw_bar_delta(data, dimensions, format, colors, 0, bar_length);
+	}
+}
+
+void
+wob_image_cache_destroy(struct wob_image_cache *cache)
+{
+	for (size_t i = 0; i < WOB_IMAGE_CACHE_SIZE; ++i) {
+		free(cache->entries[i].chrome);
+	}
+
+	*cache = (struct wob_image_cache) {0};
+}
@@ -0,0 +1,38 @@
+#ifndef _WOB_IMAGE_CACHE_H
+#define _WOB_IMAGE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// styles come from a small fixed set, normal and overflow colors of a few of them fit easily
+#define WOB_IMAGE_CACHE_SIZE 8
+
+struct wob_image_cache_entry {
+	// pixels stand for the style and its overflow state, dimensions are already scaled
+	struct wob_dimensions dimensions;
+	enum wob_pixel_format format;
+	struct wob_packed_colors colors;
+	// background, border and padding without any bar
+	void *chrome;
+	// higher is more recently used, 0 is a free entry
+	unsigned long used;
+};
+
+struct wob_image_cache {
+	struct wob_image_cache_entry entries[WOB_IMAGE_CACHE_SIZE];
+	unsigned long clock;
+	unsigned long hits;
+	unsigned long misses;
+};
+
+void wob_image_cache_init(struct wob_image_cache *cache);
+
+const void *wob_image_cache_get(struct wob_image_cache *cache, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors);
+
+void wob_image_cache_draw(struct wob_image_cache *cache, void *data, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors, size_t bar_length);
+
+void wob_image_cache_destroy(struct wob_image_cache *cache);
+
+#endif
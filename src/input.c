@@ -0,0 +1,147 @@
+#define WOB_FILE "input.c"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "input.h"
+#include "log.h"
+
+void
+wob_input_init(struct wob_input *input, int fd)
+{
+	input->fd = fd;
+	input->length = 0;
+	input->offset = 0;
+	input->discarding = false;
+}
+
+ssize_t
+wob_input_read(struct wob_input *input)
+{
+	// move partial trailing line to the front, it is at most one line long
+	if (input->offset > 0) {
+		memmove(input->buffer, input->buffer + input->offset, input->length - input->offset);
+		input->length -= input->offset;
+		input->offset = 0;
+	}
+
+	if (input->length == WOB_INPUT_BUFFER_LENGTH) {
+		wob_log_warn("Input line is longer than %d bytes, discarding it", WOB_INPUT_BUFFER_LENGTH);
+		input->length = 0;
+		input->discarding = true;
+	}
+
+	ssize_t bytes_read;
+	do {
+		bytes_read = read(input->fd, input->buffer + input->length, WOB_INPUT_BUFFER_LENGTH - input->length);
+	} while (bytes_read == -1 && errno == EINTR);
+
+	if (bytes_read > 0) {
+		input->length += bytes_read;
+	}
+
+	return bytes_read;
+}
+
+char *
+wob_input_next_line(struct wob_input *input)
+{
+	while (input->offset < input->length) {
+		char *line = input->buffer + input->offset;
+		char *newline = memchr(line, '\n', input->length - input->offset);
+		if (newline == NULL) {
+			return NULL;
+		}
+
+		*newline = '\0';
+		input->offset = newline - input->buffer + 1;
+
+		if (input->discarding) {
+			input->discarding = false;
+			continue;
+		}
+
+		return line;
+	}
+
+	return NULL;
+}
+
+char *
+wob_input_last_line(struct wob_input *input)
+{
+	// unterminated rest of the stream, only meaningful after read() returned EOF
+	if (input->discarding || input->offset >= input->length) {
+		return NULL;
+	}
+
+	char *line = input->buffer + input->offset;
+	input->buffer[input->length] = '\0';
+	input->offset = input->length;
+
+	return line;
+}
+
+bool
+wob_input_parse_value(const char *token, enum wob_input_operation *operation, unsigned long *amount)
+{
+	switch (*token) {
+		case '+':
+			*operation = WOB_INPUT_OPERATION_INCREASE;
+			token += 1;
+			break;
+		case '-':
+			*operation = WOB_INPUT_OPERATION_DECREASE;
+			token += 1;
+			break;
+		case '=':
+			*operation = WOB_INPUT_OPERATION_SET;
+			token += 1;
+			break;
+		default:
+			*operation = WOB_INPUT_OPERATION_SET;
+			break;
+	}
+
+	// strtoul() would also accept whitespace and a second sign
+	if (*token < '0' || *token > '9') {
+		return false;
+	}
+
+	char *str_end;
+	unsigned long value = strtoul(token, &str_end, 10);
+	if (*str_end != '\0') {
+		return false;
+	}
+
+	*amount = value;
+
+	return true;
+}
+
+unsigned long
+wob_input_apply_value(unsigned long current, enum wob_input_operation operation, unsigned long amount, unsigned long max, bool wrap)
+{
+	unsigned long value = 0;
+	switch (operation) {
+		case WOB_INPUT_OPERATION_SET:
+			// absolute values are taken as they are, overflow is up to the caller
+			return amount;
+		case WOB_INPUT_OPERATION_INCREASE:
+			value = amount > ULONG_MAX - current ? ULONG_MAX : current + amount;
+			break;
+		case WOB_INPUT_OPERATION_DECREASE:
+			value = amount > current ? 0 : current - amount;
+			break;
+	}
+
+	if (value <= max) {
+		return value;
+	}
+
+	// same rule overflow_mode applies when showing an absolute value, max + 20 wraps to 20
+	return wrap && max > 0 ? value % max : max;
+}
@@ -0,0 +1,39 @@
+#ifndef _WOB_INPUT_H
+#define _WOB_INPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// default pipe capacity on Linux, so a single read() drains a flooded FIFO
+#define WOB_INPUT_BUFFER_LENGTH 65536
+
+enum wob_input_operation {
+	WOB_INPUT_OPERATION_SET,
+	WOB_INPUT_OPERATION_INCREASE,
+	WOB_INPUT_OPERATION_DECREASE,
+};
+
+struct wob_input {
+	int fd;
+	// lines are parsed in place, one extra byte to always have room for the NUL terminator
+	char buffer[WOB_INPUT_BUFFER_LENGTH + 1];
+	size_t length;
+	size_t offset;
+	// line did not fit into the buffer, skip everything up to the next newline
+	bool discarding;
+};
+
+void wob_input_init(struct wob_input *input, int fd);
+
+ssize_t wob_input_read(struct wob_input *input);
+
+char *wob_input_next_line(struct wob_input *input);
+
+char *wob_input_last_line(struct wob_input *input);
+
+bool wob_input_parse_value(const char *token, enum wob_input_operation *operation, unsigned long *amount);
+
+unsigned long wob_input_apply_value(unsigned long current, enum wob_input_operation operation, unsigned long amount, unsigned long max, bool wrap);
+
+#endif
@@ -0,0 +1,126 @@
+#define WOB_FILE "latency.c"
+
+#include <stddef.h>
+
+#include "latency.h"
+#include "log.h"
+
+static const char *stage_names[] = {
+	"input to commit",
+	"render",
+	"commit to present",
+	"input to present",
+};
+
+size_t
+bucket_index(uint64_t usec)
+{
+	if (usec < 8) {
+		return usec;
+	}
+
+	size_t msb = 3;
+	while (msb < 63 && (usec >> (msb + 1)) != 0) {
+		msb += 1;
+	}
+
+	size_t index = (msb - 2) * 8 + ((usec >> (msb - 3)) & 7);
+	if (index >= WOB_LATENCY_BUCKETS) {
+		return WOB_LATENCY_BUCKETS - 1;
+	}
+
+	return index;
+}
+
+uint64_t
+bucket_lower_bound(size_t index)
+{
+	if (index < 8) {
+		return index;
+	}
+
+	return (uint64_t) (8 + index % 8) << (index / 8 - 1);
+}
+
+void
+wob_latency_histogram_add(struct wob_latency_histogram *histogram, uint64_t usec)
+{
+	histogram->buckets[bucket_index(usec)] += 1;
+	histogram->count += 1;
+	if (usec > histogram->max_usec) {
+		histogram->max_usec = usec;
+	}
+}
+
+uint64_t
+wob_latency_histogram_percentile(const struct wob_latency_histogram *histogram, double percentile)
+{
+	if (histogram->count == 0) {
+		return 0;
+	}
+
+	unsigned long rank = (unsigned long) (percentile * histogram->count);
+	if ((double) rank < percentile * histogram->count) {
+		rank += 1;
+	}
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	unsigned long seen = 0;
+	for (size_t i = 0; i < WOB_LATENCY_BUCKETS; ++i) {
+		seen += histogram->buckets[i];
+		if (seen >= rank) {
+			// report upper bound of the bucket, but never more than what was actually measured
+			uint64_t upper_bound = i + 1 < WOB_LATENCY_BUCKETS ? bucket_lower_bound(i + 1) - 1 : histogram->max_usec;
+			return upper_bound < histogram->max_usec ? upper_bound : histogram->max_usec;
+		}
+	}
+
+	return histogram->max_usec;
+}
+
+uint64_t
+wob_latency_elapsed_usec(struct timespec from, struct timespec to)
+{
+	int64_t elapsed_nsec = ((int64_t) to.tv_sec - (int64_t) from.tv_sec) * 1000000000 + ((int64_t) to.tv_nsec - (int64_t) from.tv_nsec);
+	if (elapsed_nsec < 0) {
+		return 0;
+	}
+
+	return (uint64_t) elapsed_nsec / 1000;
+}
+
+void
+wob_latency_record_presented(struct wob_latency *latency, const struct wob_frame_timing *timing, struct timespec presented)
+{
+	wob_latency_histogram_add(&latency->stages[WOB_LATENCY_INPUT_TO_COMMIT], wob_latency_elapsed_usec(timing->input, timing->commit));
+	wob_latency_histogram_add(&latency->stages[WOB_LATENCY_RENDER], wob_latency_elapsed_usec(timing->render_start, timing->render_end));
+	wob_latency_histogram_add(&latency->stages[WOB_LATENCY_COMMIT_TO_PRESENT], wob_latency_elapsed_usec(timing->commit, presented));
+	wob_latency_histogram_add(&latency->stages[WOB_LATENCY_INPUT_TO_PRESENT], wob_latency_elapsed_usec(timing->input, presented));
+}
+
+void
+wob_latency_record_discarded(struct wob_latency *latency)
+{
+	latency->discarded += 1;
+}
+
+void
+wob_latency_log(const struct wob_latency *latency, wob_log_importance importance)
+{
+	for (size_t i = 0; i < WOB_LATENCY_STAGES_COUNT; ++i) {
+		const struct wob_latency_histogram *histogram = &latency->stages[i];
+		// percentiles scan the whole histogram, they're not computed at all when the level is filtered out
+		wob_log_at(
+			importance,
+			"Latency %s: frames = %lu, p50 = %ju us, p99 = %ju us, max = %ju us",
+			stage_names[i],
+			histogram->count,
+			(uintmax_t) wob_latency_histogram_percentile(histogram, 0.5),
+			(uintmax_t) wob_latency_histogram_percentile(histogram, 0.99),
+			(uintmax_t) histogram->max_usec
+		);
+	}
+	wob_log_at(importance, "Latency: %lu frames discarded without being presented", latency->discarded);
+}
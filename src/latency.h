@@ -0,0 +1,51 @@
+#ifndef _WOB_LATENCY_H
+#define _WOB_LATENCY_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "log.h"
+
+// 8 buckets per power of two, so percentiles are within 12.5 % of the real value, the last one starts at ~126 seconds and takes everything longer
+#define WOB_LATENCY_BUCKETS 200
+
+enum wob_latency_stage {
+	WOB_LATENCY_INPUT_TO_COMMIT,
+	WOB_LATENCY_RENDER,
+	WOB_LATENCY_COMMIT_TO_PRESENT,
+	WOB_LATENCY_INPUT_TO_PRESENT,
+	WOB_LATENCY_STAGES_COUNT,
+};
+
+struct wob_latency_histogram {
+	unsigned long count;
+	uint64_t max_usec;
+	unsigned long buckets[WOB_LATENCY_BUCKETS];
+};
+
+// all timestamps are taken with the presentation clock
+struct wob_frame_timing {
+	struct timespec input;
+	struct timespec render_start;
+	struct timespec render_end;
+	struct timespec commit;
+};
+
+struct wob_latency {
+	struct wob_latency_histogram stages[WOB_LATENCY_STAGES_COUNT];
+	unsigned long discarded;
+};
+
+void wob_latency_histogram_add(struct wob_latency_histogram *histogram, uint64_t usec);
+
+uint64_t wob_latency_histogram_percentile(const struct wob_latency_histogram *histogram, double percentile);
+
+uint64_t wob_latency_elapsed_usec(struct timespec from, struct timespec to);
+
+void wob_latency_record_presented(struct wob_latency *latency, const struct wob_frame_timing *timing, struct timespec presented);
+
+void wob_latency_record_discarded(struct wob_latency *latency);
+
+void wob_latency_log(const struct wob_latency *latency, wob_log_importance importance);
+
+#endif
@@ -19,21 +19,38 @@
 #define COLOR_LIGHT_GRAY "\x1B[0;37m"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "log.h"
 
-static wob_log_importance min_importance_to_log = WOB_LOG_WARN;
+wob_log_importance wob_log_min_importance = WOB_LOG_WARN;
 
 static bool use_colors = false;
 
+// connected datagram socket of the journal, records are sent there instead of stderr
+static int journal_fd = -1;
+
+// records are formatted into the ring and written by wob_log_flush(), usually once per main loop iteration
+static struct {
+	char data[WOB_LOG_RING_SIZE];
+	// offsets grow forever, position in data is offset % WOB_LOG_RING_SIZE
+	size_t head;
+	size_t tail;
+	bool flush_at_exit;
+} ring;
+
 static const char *verbosity_names[] = {
 	"DEBUG",
 	"INFO",
@@ -42,6 +59,15 @@ static const char *verbosity_names[] = {
 	"PANIC",
 };
 
+// syslog priorities, PANIC is LOG_CRIT
+static const int journal_priorities[] = {
+	7,
+	6,
+	4,
+	3,
+	2,
+};
+
 static const char *verbosity_colors[] = {
 	COLOR_LIGHT_CYAN,
 	COLOR_GREEN,
@@ -51,27 +77,140 @@ static const char *verbosity_colors[] = {
 };
 
 void
-wob_log(const wob_log_importance importance, const char *file, const int line, const char *fmt, ...)
+wob_log_flush(void)
+{
+	while (ring.head != ring.tail) {
+		size_t start = ring.tail % WOB_LOG_RING_SIZE;
+		size_t length = ring.head - ring.tail;
+		struct iovec iov[2] = {
+			{.iov_base = ring.data + start, .iov_len = length},
+			{.iov_base = ring.data, .iov_len = 0},
+		};
+		if (start + length > WOB_LOG_RING_SIZE) {
+			iov[0].iov_len = WOB_LOG_RING_SIZE - start;
+			iov[1].iov_len = length - iov[0].iov_len;
+		}
+
+		ssize_t written = writev(STDERR_FILENO, iov, iov[1].iov_len > 0 ? 2 : 1);
+		if (written == -1 && errno == EINTR) {
+			continue;
+		}
+		if (written <= 0) {
+			// nowhere to log that logging failed, drop the records
+			ring.tail = ring.head;
+			break;
+		}
+
+		ring.tail += written;
+	}
+}
+
+void
+flush_at_exit(void)
+{
+	wob_log_flush();
+}
+
+void
+ring_push(const char *record, size_t length)
 {
-	if (importance < min_importance_to_log) {
+	if (ring.head - ring.tail + length > WOB_LOG_RING_SIZE) {
+		wob_log_flush();
+	}
+
+	size_t start = ring.head % WOB_LOG_RING_SIZE;
+	size_t first = length < WOB_LOG_RING_SIZE - start ? length : WOB_LOG_RING_SIZE - start;
+	memcpy(ring.data + start, record, first);
+	memcpy(ring.data, record + first, length - first);
+	ring.head += length;
+}
+
+void
+journal_field_size(uint8_t size[8], uint64_t length)
+{
+	for (int i = 0; i < 8; ++i) {
+		size[i] = (length >> (8 * i)) & 0xFF;
+	}
+}
+
+bool
+journal_send(const wob_log_importance importance, const char *file, const int line, const char *value, const char *message, size_t message_length)
+{
+	char fields[256];
+	int fields_length = snprintf(fields, sizeof(fields), "PRIORITY=%d\nSYSLOG_IDENTIFIER=wob\nCODE_FILE=%s\nCODE_LINE=%d\n", journal_priorities[importance], file, line);
+	if (fields_length < 0 || (size_t) fields_length >= sizeof(fields)) {
+		return false;
+	}
+
+	// binary field format, the values may contain newlines
+	uint8_t message_size[8];
+	journal_field_size(message_size, message_length);
+	uint8_t value_size[8];
+	journal_field_size(value_size, value != NULL ? strlen(value) : 0);
+
+	struct iovec iov[] = {
+		{.iov_base = fields, .iov_len = fields_length},
+		{.iov_base = "MESSAGE\n", .iov_len = strlen("MESSAGE\n")},
+		{.iov_base = message_size, .iov_len = sizeof(message_size)},
+		{.iov_base = (char *) message, .iov_len = message_length},
+		{.iov_base = "\n", .iov_len = 1},
+		{.iov_base = "WOB_VALUE\n", .iov_len = strlen("WOB_VALUE\n")},
+		{.iov_base = value_size, .iov_len = sizeof(value_size)},
+		{.iov_base = (char *) value, .iov_len = value != NULL ? strlen(value) : 0},
+		{.iov_base = "\n", .iov_len = 1},
+	};
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = value != NULL ? 9 : 5,
+	};
+
+	return sendmsg(journal_fd, &msg, MSG_NOSIGNAL) != -1;
+}
+
+void
+log_va(const wob_log_importance importance, const char *file, const int line, const char *value, const char *fmt, va_list args)
+{
+	if (importance < wob_log_min_importance) {
 		return;
 	}
 
+	if (journal_fd != -1) {
+		char message[WOB_LOG_RECORD_SIZE];
+		va_list journal_args;
+		va_copy(journal_args, args);
+		int length = vsnprintf(message, sizeof(message), fmt, journal_args);
+		va_end(journal_args);
+		if (length >= 0 && (size_t) length >= sizeof(message)) {
+			length = sizeof(message) - 1;
+		}
+
+		// journal may refuse the record, stderr still gets it then
+		if (length >= 0 && journal_send(importance, file, line, value, message, length)) {
+			return;
+		}
+	}
+
+	if (!ring.flush_at_exit) {
+		// wob_log_panic() and returning from main() both end in exit()
+		ring.flush_at_exit = atexit(flush_at_exit) == 0;
+	}
+
 	struct timespec ts;
 	if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
-		fprintf(stderr, "clock_gettime() failed: %s\n", strerror(errno));
 		ts.tv_sec = 0;
 		ts.tv_nsec = 0;
 	}
 
 	// formatting time via localtime() requires open syscall (to read /etc/localtime)
 	// and that is problematic with seccomp rules in place
-	fprintf(
-		stderr,
+	char record[WOB_LOG_RECORD_SIZE];
+	int length = snprintf(
+		record,
+		sizeof(record),
 		"%jd.%06ld %s%-5s%s %s%s:%d:%s ",
 		(intmax_t) ts.tv_sec,
 		ts.tv_nsec / 1000,
-		verbosity_colors[importance],
+		use_colors ? verbosity_colors[importance] : "",
 		verbosity_names[importance],
 		use_colors ? COLOR_RESET : "",
 		use_colors ? COLOR_LIGHT_GRAY : "",
@@ -80,17 +219,104 @@ wob_log(const wob_log_importance importance, const char *file, const int line, c
 		use_colors ? COLOR_RESET : ""
 	);
 
+	if (length >= 0 && (size_t) length < sizeof(record) - 1) {
+		int message_length = vsnprintf(record + length, sizeof(record) - length, fmt, args);
+		if (message_length > 0) {
+			length += message_length;
+		}
+	}
+
+	// too long records are truncated, but always end with a newline
+	if (length < 0 || (size_t) length > sizeof(record) - 1) {
+		length = sizeof(record) - 1;
+	}
+	record[length] = '\n';
+	ring_push(record, length + 1);
+
+	// errors may be followed by a crash, don't keep them waiting for the next loop iteration
+	if (importance >= WOB_LOG_ERROR) {
+		wob_log_flush();
+	}
+}
+
+void
+wob_log(const wob_log_importance importance, const char *file, const int line, const char *fmt, ...)
+{
 	va_list args;
 	va_start(args, fmt);
-	vfprintf(stderr, fmt, args);
+	log_va(importance, file, line, NULL, fmt, args);
 	va_end(args);
-	fprintf(stderr, "\n");
+}
+
+void
+wob_log_value(const wob_log_importance importance, const char *file, const int line, const char *value, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	log_va(importance, file, line, value, fmt, args);
+	va_end(args);
+}
+
+bool
+wob_log_is_journal_stream(const int fd)
+{
+	// systemd sets JOURNAL_STREAM to <device>:<inode> of the stream it connected stdout and stderr to
+	const char *journal_stream = getenv("JOURNAL_STREAM");
+	unsigned long long device, inode;
+	if (journal_stream == NULL || sscanf(journal_stream, "%llu:%llu", &device, &inode) != 2) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		return false;
+	}
+
+	return st.st_dev == device && st.st_ino == inode;
+}
+
+bool
+wob_log_use_journal(const char *socket_path)
+{
+	if (journal_fd != -1) {
+		close(journal_fd);
+		journal_fd = -1;
+	}
+
+	if (socket_path == NULL) {
+		return true;
+	}
+
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	if (strlen(socket_path) >= sizeof(address.sun_path)) {
+		wob_log_warn("Journal socket path %s is too long", socket_path);
+		return false;
+	}
+	strcpy(address.sun_path, socket_path);
+
+	// socket is connected before wob_pledge(), afterwards every record is a single sendmsg()
+	int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (fd == -1) {
+		wob_log_warn("socket() failed: %s", strerror(errno));
+		return false;
+	}
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	if (connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+		wob_log_warn("connect(%s) failed: %s", socket_path, strerror(errno));
+		close(fd);
+		return false;
+	}
+
+	journal_fd = fd;
+
+	return true;
 }
 
 void
 wob_log_set_level(const wob_log_importance importance)
 {
-	min_importance_to_log = importance;
+	wob_log_min_importance = importance;
 }
 
 void
@@ -102,7 +328,7 @@ wob_log_use_colors(const bool colors)
 void
 wob_log_inc_verbosity(void)
 {
-	if (min_importance_to_log != WOB_LOG_DEBUG) {
-		min_importance_to_log -= 1;
+	if (wob_log_min_importance != WOB_LOG_DEBUG) {
+		wob_log_min_importance -= 1;
 	}
 }
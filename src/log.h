@@ -3,6 +3,15 @@
 
 #include <stdbool.h>
 
+#include "global_configuration.h"
+
+// bytes of formatted records waiting for wob_log_flush()
+#define WOB_LOG_RING_SIZE 16384
+// longer records are truncated
+#define WOB_LOG_RECORD_SIZE 1024
+
+#define WOB_LOG_JOURNAL_SOCKET "/run/systemd/journal/socket"
+
 typedef enum {
 	WOB_LOG_DEBUG = 0,
 	WOB_LOG_INFO = 1,
@@ -11,18 +20,54 @@ typedef enum {
 	WOB_LOG_PANIC = 4,
 } wob_log_importance;
 
+// only wob_log_set_level() and friends should write this
+extern wob_log_importance wob_log_min_importance;
+
+// first comparison is against a constant, so messages below WOB_LOG_MIN_LEVEL compile to nothing
+static inline bool
+wob_log_enabled(const wob_log_importance importance)
+{
+	return importance >= WOB_LOG_MIN_LEVEL && importance >= wob_log_min_importance;
+}
+
 void wob_log(wob_log_importance importance, const char *file, int line, const char *fmt, ...);
 
+// value is sent to the journal as WOB_VALUE field, other backends only log the message
+void wob_log_value(wob_log_importance importance, const char *file, int line, const char *value, const char *fmt, ...);
+
+void wob_log_flush(void);
+
+bool wob_log_is_journal_stream(int fd);
+
+// NULL goes back to logging to stderr
+bool wob_log_use_journal(const char *socket_path);
+
 void wob_log_set_level(wob_log_importance importance);
 
 void wob_log_inc_verbosity(void);
 
 void wob_log_use_colors(bool use_colors);
 
-#define wob_log_debug(...) wob_log(WOB_LOG_DEBUG, WOB_FILE, __LINE__, __VA_ARGS__)
-#define wob_log_info(...) wob_log(WOB_LOG_INFO, WOB_FILE, __LINE__, __VA_ARGS__)
-#define wob_log_warn(...) wob_log(WOB_LOG_WARN, WOB_FILE, __LINE__, __VA_ARGS__)
-#define wob_log_error(...) wob_log(WOB_LOG_ERROR, WOB_FILE, __LINE__, __VA_ARGS__)
+// arguments are not evaluated unless the message is going to be logged
+#define wob_log_at(importance, ...)                                                                                                                                                                    \
+	do {                                                                                                                                                                                               \
+		if (wob_log_enabled(importance)) {                                                                                                                                                             \
+			wob_log(importance, WOB_FILE, __LINE__, __VA_ARGS__);                                                                                                                                      \
+		}                                                                                                                                                                                              \
+	} while (0)
+
+#define wob_log_value_at(importance, value, ...)                                                                                                                                                       \
+	do {                                                                                                                                                                                               \
+		if (wob_log_enabled(importance)) {                                                                                                                                                             \
+			wob_log_value(importance, WOB_FILE, __LINE__, value, __VA_ARGS__);                                                                                                                         \
+		}                                                                                                                                                                                              \
+	} while (0)
+
+#define wob_log_debug(...) wob_log_at(WOB_LOG_DEBUG, __VA_ARGS__)
+#define wob_log_info(...) wob_log_at(WOB_LOG_INFO, __VA_ARGS__)
+#define wob_log_info_value(value, ...) wob_log_value_at(WOB_LOG_INFO, value, __VA_ARGS__)
+#define wob_log_warn(...) wob_log_at(WOB_LOG_WARN, __VA_ARGS__)
+#define wob_log_error(...) wob_log_at(WOB_LOG_ERROR, __VA_ARGS__)
 #define wob_log_panic(...)                                                                                                                                                                             \
 	wob_log(WOB_LOG_PANIC, WOB_FILE, __LINE__, __VA_ARGS__);                                                                                                                                           \
 	exit(2)
@@ -10,26 +10,25 @@
 #include "config.h"
 #include "global_configuration.h"
 #include "log.h"
+#include "server.h"
 #include "wob.h"
 
 int
 main(int argc, char **argv)
 {
 	wob_log_use_colors(isatty(STDERR_FILENO));
+	// under systemd, records go straight to the journal instead of being parsed back from text
+	if (wob_log_is_journal_stream(STDERR_FILENO)) {
+		wob_log_use_journal(WOB_LOG_JOURNAL_SOCKET);
+	}
 	wob_log_level_warn();
 
-	// libc is doing fstat syscall to determine the optimal buffer size and that can be problematic to wob_pledge()
-	// to solve this problem we can just pass the optimal buffer ourselves
-	static char stdin_buffer[INPUT_BUFFER_LENGTH];
-	if (setvbuf(stdin, stdin_buffer, _IOFBF, sizeof(stdin_buffer)) != 0) {
-		wob_log_error("Failed to set stdin buffer size to %zu", sizeof(stdin_buffer));
-		return EXIT_FAILURE;
-	}
 	setvbuf(stdout, NULL, _IONBF, 0);
 	setvbuf(stderr, NULL, _IONBF, 0);
 
 	static struct option long_options[] = {
 		{"config", required_argument, NULL, 'c'},
+		{"socket", required_argument, NULL, 's'},
 		{"help", no_argument, NULL, 'h'},
 		{"version", no_argument, NULL, 'V'},
 		{"verbose", no_argument, NULL, 'v'},
@@ -39,6 +38,7 @@ main(int argc, char **argv)
 	const char *usage =
 		"Usage: wob [options]\n"
 		"  -c, --config <config>  Specify a config file.\n"
+		"  -s, --socket <path>    Accept values from clients connecting to a Unix socket instead of reading stdin.\n"
 		"  -v, --verbose          Increase verbosity of messages, defaults to errors and warnings only.\n"
 		"  -h, --help             Show help message and quit.\n"
 		"  -V, --version          Show the version number and quit.\n"
@@ -47,7 +47,8 @@ main(int argc, char **argv)
 	int c;
 	int option_index = 0;
 	char *wob_config_path = NULL;
-	while ((c = getopt_long(argc, argv, "hvVc:", long_options, &option_index)) != -1) {
+	const char *socket_path = NULL;
+	while ((c = getopt_long(argc, argv, "hvVc:s:", long_options, &option_index)) != -1) {
 		switch (c) {
 			case 'V':
 				printf("wob version " WOB_VERSION "\n");
@@ -71,6 +72,9 @@ main(int argc, char **argv)
 				free(wob_config_path);
 				wob_config_path = strdup(optarg);
 				break;
+			case 's':
+				socket_path = optarg;
+				break;
 			default:
 				fprintf(stderr, "%s", usage);
 				free(wob_config_path);
@@ -102,5 +106,12 @@ main(int argc, char **argv)
 	wob_config_debug(config);
 	free(wob_config_path);
 
-	return wob_run(config);
+	// listening socket has to be set up before wob_pledge()
+	int listen_fd = socket_path != NULL ? wob_server_listen(socket_path) : wob_server_activated_fd();
+	if (socket_path != NULL && listen_fd == -1) {
+		wob_config_destroy(config);
+		return EXIT_FAILURE;
+	}
+
+	return wob_run(config, listen_fd);
 }
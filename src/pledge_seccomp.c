@@ -17,8 +17,14 @@ wob_pledge(void)
 {
 	// clang-format off
 	const int scmp_sc[] = {
+		SCMP_SYS(accept),
+		SCMP_SYS(accept4),
+		SCMP_SYS(brk),
 		SCMP_SYS(clock_gettime),
 		SCMP_SYS(close),
+		SCMP_SYS(epoll_ctl),
+		SCMP_SYS(epoll_pwait),
+		SCMP_SYS(epoll_wait),
 		SCMP_SYS(exit),
 		SCMP_SYS(exit_group),
 		SCMP_SYS(fcntl),
@@ -27,16 +33,25 @@ wob_pledge(void)
 		SCMP_SYS(gettimeofday),
 		SCMP_SYS(_llseek),
 		SCMP_SYS(lseek),
+		SCMP_SYS(madvise),
 		SCMP_SYS(mmap),
 		SCMP_SYS(mprotect),
+		SCMP_SYS(mremap),
 		SCMP_SYS(munmap),
 		SCMP_SYS(poll),
 		SCMP_SYS(ppoll),
+		SCMP_SYS(pread64),
 		SCMP_SYS(read),
 		SCMP_SYS(readv),
 		SCMP_SYS(recvmsg),
 		SCMP_SYS(restart_syscall),
+		SCMP_SYS(rt_sigreturn),
 		SCMP_SYS(sendmsg),
+		SCMP_SYS(sigreturn),
+		SCMP_SYS(timerfd_settime),
+#ifdef __SNR_timerfd_settime64
+		SCMP_SYS(timerfd_settime64),
+#endif
 		SCMP_SYS(write),
 		SCMP_SYS(writev),
 	};
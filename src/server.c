@@ -0,0 +1,185 @@
+#define WOB_FILE "server.c"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "input.h"
+#include "log.h"
+#include "server.h"
+
+// first file descriptor passed by socket activation, see sd_listen_fds(3)
+#define WOB_LISTEN_FDS_START 3
+
+bool
+is_listening_socket(int fd)
+{
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISSOCK(st.st_mode)) {
+		return false;
+	}
+
+	int accepting = 0;
+	socklen_t length = sizeof(accepting);
+	if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &length) != 0) {
+		return false;
+	}
+
+	return accepting != 0;
+}
+
+int
+wob_server_activated_fd(void)
+{
+	const char *listen_pid = getenv("LISTEN_PID");
+	const char *listen_fds = getenv("LISTEN_FDS");
+	if (listen_pid != NULL && listen_fds != NULL && strtol(listen_pid, NULL, 10) == (long) getpid()) {
+		long count = strtol(listen_fds, NULL, 10);
+		unsetenv("LISTEN_PID");
+		unsetenv("LISTEN_FDS");
+		unsetenv("LISTEN_FDNAMES");
+
+		if (count > 1) {
+			wob_log_warn("Received %ld sockets from socket activation, only the first one is used", count);
+		}
+		// ListenFIFO passes the FIFO here too, that is handled as plain stdin
+		if (count >= 1 && is_listening_socket(WOB_LISTEN_FDS_START)) {
+			fcntl(WOB_LISTEN_FDS_START, F_SETFD, FD_CLOEXEC);
+			wob_log_info("Using socket activated listening socket %d", WOB_LISTEN_FDS_START);
+			return WOB_LISTEN_FDS_START;
+		}
+	}
+
+	// StandardInput=socket together with ListenStream passes the listening socket as stdin
+	if (is_listening_socket(STDIN_FILENO)) {
+		wob_log_info("Standard input is a listening socket, accepting clients on it");
+		return STDIN_FILENO;
+	}
+
+	return -1;
+}
+
+int
+wob_server_listen(const char *path)
+{
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		wob_log_error("Socket path %s is too long", path);
+		return -1;
+	}
+	strcpy(address.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1) {
+		wob_log_error("socket() failed: %s", strerror(errno));
+		return -1;
+	}
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	// socket can't be removed on exit once seccomp is in place, so a stale one is expected, a live one is not
+	struct stat st;
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+		if (connect(fd, (struct sockaddr *) &address, sizeof(address)) == 0) {
+			wob_log_error("Socket %s is already used by another process", path);
+			close(fd);
+			return -1;
+		}
+
+		close(fd);
+		unlink(path);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd == -1) {
+			wob_log_error("socket() failed: %s", strerror(errno));
+			return -1;
+		}
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+
+	if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+		wob_log_error("bind(%s) failed: %s", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	if (listen(fd, SOMAXCONN) != 0) {
+		wob_log_error("listen(%s) failed: %s", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	wob_log_info("Listening on %s", path);
+
+	return fd;
+}
+
+void
+wob_server_init(struct wob_server *server, int listen_fd)
+{
+	server->listen_fd = listen_fd;
+	server->clients_count = 0;
+
+	// pages of unused slots are never touched, so they don't cost any memory
+	server->slots = calloc(WOB_SERVER_MAX_CLIENTS, sizeof(struct wob_input));
+	if (server->slots == NULL) {
+		wob_log_panic("calloc failed");
+	}
+	for (size_t i = 0; i < WOB_SERVER_MAX_CLIENTS; ++i) {
+		server->clients[i] = &server->slots[i];
+	}
+
+	// connection can go away between poll() and accept(), that must not block the loop
+	fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+}
+
+struct wob_input *
+wob_server_accept(struct wob_server *server)
+{
+	if (server->clients_count == WOB_SERVER_MAX_CLIENTS) {
+		return NULL;
+	}
+
+	int fd = accept(server->listen_fd, NULL, NULL);
+	if (fd == -1) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+			wob_log_error("accept() failed: %s", strerror(errno));
+		}
+		return NULL;
+	}
+
+	struct wob_input *client = server->clients[server->clients_count];
+	wob_input_init(client, fd);
+	server->clients_count += 1;
+	wob_log_debug("Accepted client %d, %zu clients connected", fd, server->clients_count);
+
+	return client;
+}
+
+void
+wob_server_close_client(struct wob_server *server, size_t index)
+{
+	struct wob_input *client = server->clients[index];
+	wob_log_debug("Closing client %d", client->fd);
+
+	close(client->fd);
+
+	// freed slot swaps places with the last connected client
+	server->clients_count -= 1;
+	server->clients[index] = server->clients[server->clients_count];
+	server->clients[server->clients_count] = client;
+}
+
+void
+wob_server_destroy(struct wob_server *server)
+{
+	while (server->clients_count > 0) {
+		wob_server_close_client(server, server->clients_count - 1);
+	}
+
+	close(server->listen_fd);
+	free(server->slots);
+}
@@ -0,0 +1,34 @@
+#ifndef _WOB_SERVER_H
+#define _WOB_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "input.h"
+
+// further connections wait in the listen backlog until a client disconnects
+#define WOB_SERVER_MAX_CLIENTS 32
+
+struct wob_server {
+	int listen_fd;
+	// every client has its own line buffer, so concurrent writers never interleave partial lines
+	// first clients_count entries are connected, the rest are free slots
+	struct wob_input *clients[WOB_SERVER_MAX_CLIENTS];
+	size_t clients_count;
+	// allocated by wob_server_init(), accepting a client after wob_pledge() must not allocate
+	struct wob_input *slots;
+};
+
+int wob_server_activated_fd(void);
+
+int wob_server_listen(const char *path);
+
+void wob_server_init(struct wob_server *server, int listen_fd);
+
+struct wob_input *wob_server_accept(struct wob_server *server);
+
+void wob_server_close_client(struct wob_server *server, size_t index);
+
+void wob_server_destroy(struct wob_server *server);
+
+#endif
@@ -1,5 +1,8 @@
 #define WOB_FILE "shm.c"
 
+// memfd_create(), mremap() and MAP_POPULATE are not part of POSIX
+#define _GNU_SOURCE
+
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
@@ -8,50 +11,133 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include "global_configuration.h"
 #include "log.h"
 #include "shm.h"
 
+#ifdef MAP_POPULATE
+#define WOB_SHM_MAP_FLAGS (MAP_SHARED | MAP_POPULATE)
+#else
+#define WOB_SHM_MAP_FLAGS MAP_SHARED
+#endif
+
 int
-wob_shm_open()
+shm_open_anonymous(void)
 {
-	int shmid = -1;
+#ifdef WOB_HAVE_MEMFD
+	int fd = memfd_create("wob", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		wob_log_error("memfd_create() failed: %s", strerror(errno));
+		return -1;
+	}
+
+	// compositor maps the same memory, it must never shrink under it, growing is fine
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) != 0) {
+		wob_log_error("fcntl(F_ADD_SEALS) failed: %s", strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+#else
+	int fd = -1;
 	char shm_name[NAME_MAX];
 	for (int i = 0; i < UCHAR_MAX; ++i) {
 		if (snprintf(shm_name, NAME_MAX, "/wob-%d", i) >= NAME_MAX) {
 			break;
 		}
-		shmid = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
-		if (shmid > 0 || errno != EEXIST) {
+		fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd > 0 || errno != EEXIST) {
 			break;
 		}
 	}
 
-	if (shmid < 0) {
+	if (fd < 0) {
 		wob_log_error("shm_open() failed: %s", strerror(errno));
 		return -1;
 	}
 
 	if (shm_unlink(shm_name) != 0) {
 		wob_log_error("shm_unlink() failed: %s", strerror(errno));
+		close(fd);
 		return -1;
 	}
 
-	return shmid;
+	return fd;
+#endif
+}
+
+bool
+wob_shm_open(struct wob_shm *shm)
+{
+	shm->fd = shm_open_anonymous();
+	shm->data = NULL;
+	shm->size = 0;
+
+	return shm->fd >= 0;
 }
 
-void *
-wob_shm_allocate(int shmid, size_t size)
+bool
+wob_shm_reserve(struct wob_shm *shm, size_t size)
 {
-	if (ftruncate(shmid, size) != 0) {
-		wob_log_error("ftruncate(%d) failed: %s", shmid, strerror(errno));
-		return NULL;
+	if (size <= shm->size) {
+		return true;
 	}
 
-	void *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shmid, 0);
-	if (buffer == MAP_FAILED) {
+	if (ftruncate(shm->fd, size) != 0) {
+		wob_log_error("ftruncate(%d) failed: %s", shm->fd, strerror(errno));
+		return false;
+	}
+
+	void *data;
+#ifdef WOB_HAVE_MREMAP
+	if (shm->data != NULL) {
+		data = mremap(shm->data, shm->size, size, MREMAP_MAYMOVE);
+		if (data == MAP_FAILED) {
+			wob_log_error("mremap() failed: %s", strerror(errno));
+			return false;
+		}
+#ifdef MADV_POPULATE_WRITE
+		// prefault only the new tail, failure just means the first draw faults the pages in
+		size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+		size_t tail = shm->size / page_size * page_size;
+		madvise((char *) data + tail, size - tail, MADV_POPULATE_WRITE);
+#endif
+	}
+	else {
+		data = mmap(NULL, size, PROT_READ | PROT_WRITE, WOB_SHM_MAP_FLAGS, shm->fd, 0);
+	}
+#else
+	if (shm->data != NULL) {
+		munmap(shm->data, shm->size);
+		shm->data = NULL;
+		shm->size = 0;
+	}
+	data = mmap(NULL, size, PROT_READ | PROT_WRITE, WOB_SHM_MAP_FLAGS, shm->fd, 0);
+#endif
+	if (data == MAP_FAILED) {
 		wob_log_error("mmap() failed: %s", strerror(errno));
-		return NULL;
+		return false;
+	}
+
+	wob_log_debug("shm %d grown from %zu to %zu bytes", shm->fd, shm->size, size);
+	shm->data = data;
+	shm->size = size;
+
+	return true;
+}
+
+void
+wob_shm_close(struct wob_shm *shm)
+{
+	if (shm->data != NULL) {
+		munmap(shm->data, shm->size);
+	}
+	if (shm->fd >= 0) {
+		close(shm->fd);
 	}
 
-	return buffer;
+	shm->fd = -1;
+	shm->data = NULL;
+	shm->size = 0;
 }
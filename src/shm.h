@@ -1,11 +1,21 @@
 #ifndef _WOB_SHM_H
 #define _WOB_SHM_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
-int wob_shm_open();
+struct wob_shm {
+	int fd;
+	// mapping is only ever grown, smaller sizes reuse it as is
+	void *data;
+	size_t size;
+};
 
-void *wob_shm_allocate(int shmid, size_t size);
+bool wob_shm_open(struct wob_shm *shm);
+
+bool wob_shm_reserve(struct wob_shm *shm, size_t size);
+
+void wob_shm_close(struct wob_shm *shm);
 
 #endif
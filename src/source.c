@@ -0,0 +1,183 @@
+#define WOB_FILE "source.c"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "global_configuration.h"
+#include "log.h"
+#include "source.h"
+
+#ifdef WOB_HAVE_INOTIFY
+#include <sys/inotify.h>
+#endif
+
+// sysfs attributes are at most a page, numbers are much shorter
+#define WOB_SOURCE_READ_LENGTH 64
+
+bool
+read_number(int fd, const char *path, unsigned long *value)
+{
+	char buffer[WOB_SOURCE_READ_LENGTH + 1];
+	ssize_t bytes_read;
+	do {
+		bytes_read = pread(fd, buffer, WOB_SOURCE_READ_LENGTH, 0);
+	} while (bytes_read == -1 && errno == EINTR);
+
+	if (bytes_read == -1) {
+		wob_log_warn("pread(%s) failed: %s", path, strerror(errno));
+		return false;
+	}
+	buffer[bytes_read] = '\0';
+
+	// file is truncated and rewritten by most writers, an empty read is just the middle of that
+	char *str_end;
+	unsigned long number = strtoul(buffer, &str_end, 10);
+	if (str_end == buffer) {
+		return false;
+	}
+	while (*str_end == ' ' || *str_end == '\t' || *str_end == '\n') {
+		str_end += 1;
+	}
+	if (*str_end != '\0') {
+		wob_log_warn("Invalid value '%s' in %s", buffer, path);
+		return false;
+	}
+
+	*value = number;
+
+	return true;
+}
+
+int
+wob_source_watch_create(void)
+{
+#ifdef WOB_HAVE_INOTIFY
+	int watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watch_fd == -1) {
+		wob_log_error("inotify_init1() failed: %s", strerror(errno));
+	}
+
+	return watch_fd;
+#else
+	wob_log_error("Value sources are not supported on this platform");
+	return -1;
+#endif
+}
+
+bool
+wob_source_open(struct wob_source *source, struct wob_source_config *config, int watch_fd, unsigned long default_max)
+{
+	source->config = config;
+	source->fd = -1;
+	source->wd = -1;
+	source->max = default_max;
+	source->value = 0;
+	source->dirty = false;
+
+	if (config->max_path != NULL) {
+		int max_fd = open(config->max_path, O_RDONLY | O_CLOEXEC);
+		if (max_fd == -1) {
+			wob_log_error("open(%s) failed: %s", config->max_path, strerror(errno));
+			return false;
+		}
+
+		// max of a device doesn't change, it is read only once
+		bool valid = read_number(max_fd, config->max_path, &source->max);
+		close(max_fd);
+		if (!valid || source->max == 0) {
+			wob_log_error("Source %s has no valid max value in %s", config->id, config->max_path);
+			return false;
+		}
+	}
+
+	source->fd = open(config->path, O_RDONLY | O_CLOEXEC);
+	if (source->fd == -1) {
+		wob_log_error("open(%s) failed: %s", config->path, strerror(errno));
+		return false;
+	}
+
+#ifdef WOB_HAVE_INOTIFY
+	// sysfs reports both writes from userspace and sysfs_notify() from the kernel as modifications
+	source->wd = inotify_add_watch(watch_fd, config->path, IN_MODIFY);
+	if (source->wd == -1) {
+		wob_log_error("inotify_add_watch(%s) failed: %s", config->path, strerror(errno));
+		close(source->fd);
+		source->fd = -1;
+		return false;
+	}
+#endif
+
+	// initial value is only remembered, the bar shows up on the first change
+	read_number(source->fd, config->path, &source->value);
+	wob_log_info("Watching source %s at %s, value = %lu, max = %lu", config->id, config->path, source->value, source->max);
+
+	return true;
+}
+
+bool
+wob_source_read(struct wob_source *source)
+{
+	source->dirty = false;
+
+	unsigned long value;
+	if (!read_number(source->fd, source->config->path, &value) || value == source->value) {
+		return false;
+	}
+
+	source->value = value;
+
+	return true;
+}
+
+void
+wob_source_watch_dispatch(int watch_fd, struct wob_source *sources, size_t sources_count)
+{
+#ifdef WOB_HAVE_INOTIFY
+	union {
+		struct inotify_event event;
+		char buffer[4096];
+	} events;
+
+	for (;;) {
+		ssize_t length = read(watch_fd, events.buffer, sizeof(events.buffer));
+		if (length == -1 && errno == EINTR) {
+			continue;
+		}
+		if (length <= 0) {
+			return;
+		}
+
+		// burst of writes to one file results in a single read of it
+		for (char *position = events.buffer; position < events.buffer + length;) {
+			const struct inotify_event *event = (const struct inotify_event *) position;
+			for (size_t i = 0; i < sources_count; ++i) {
+				if (sources[i].wd != event->wd) {
+					continue;
+				}
+
+				if (event->mask & IN_IGNORED) {
+					wob_log_warn("Source %s at %s was removed, not watching it anymore", sources[i].config->id, sources[i].config->path);
+					sources[i].wd = -1;
+				}
+				else {
+					sources[i].dirty = true;
+				}
+			}
+
+			position += sizeof(struct inotify_event) + event->len;
+		}
+	}
+#endif
+}
+
+void
+wob_source_close(struct wob_source *source)
+{
+	// watch goes away together with the watch descriptor
+	if (source->fd != -1) {
+		close(source->fd);
+	}
+}
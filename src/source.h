@@ -0,0 +1,31 @@
+#ifndef _WOB_SOURCE_H
+#define _WOB_SOURCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "config.h"
+
+struct wob_source {
+	struct wob_source_config *config;
+	// kept open and re-read from the start on every change
+	int fd;
+	// inotify watch descriptor, -1 once the file is gone
+	int wd;
+	unsigned long max;
+	unsigned long value;
+	// watch reported a change that was not read yet
+	bool dirty;
+};
+
+int wob_source_watch_create(void);
+
+bool wob_source_open(struct wob_source *source, struct wob_source_config *config, int watch_fd, unsigned long default_max);
+
+bool wob_source_read(struct wob_source *source);
+
+void wob_source_watch_dispatch(int watch_fd, struct wob_source *sources, size_t sources_count);
+
+void wob_source_close(struct wob_source *source);
+
+#endif
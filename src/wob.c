@@ -1,31 +1,99 @@
 #define WOB_FILE "wob.c"
 
 #include <errno.h>
-#include <poll.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
 #include <unistd.h>
 #include <wayland-client-protocol.h>
 
+#include "animation.h"
 #include "fractional-scale-v1.h"
 #include "image.h"
+#include "image_cache.h"
+#include "input.h"
+#include "latency.h"
 #include "log.h"
 #include "pledge.h"
+#include "presentation-time.h"
+#include "server.h"
 #include "shm.h"
+#include "source.h"
+#include "single-pixel-buffer-v1.h"
 #include "viewporter.h"
 #include "wlr-layer-shell-unstable-v1.h"
 #include "wob.h"
 
+// triple buffering, so there is always a free buffer while the compositor holds the current and the previous one
+#define WOB_BUFFER_POOL_SIZE 3
+// events handled per wakeup, more are simply returned by the next epoll_wait()
+#define WOB_EPOLL_EVENTS 16
+
 struct wob_buffer {
 	struct wl_buffer *wl_buffer;
+	void *shm_data;
+	// set on attach, cleared by wl_buffer.release
+	bool busy;
+	// what the buffer currently contains, so only the changed part of the bar needs to be redrawn
+	bool drawn;
+	struct wob_colors colors;
+	size_t bar_length;
+	struct wob_buffer_pool *pool;
+};
+
+struct wob_shm_pool {
+	struct wob_shm shm;
+	// lives as long as the shm, it's only resized when the shm grows, so the compositor doesn't map it again on every configure
+	struct wl_shm_pool *wl_shm_pool;
+	// buffer pools carved out of the shm ordered by offset, ranges of destroyed ones are reused first fit
+	// pool nobody uses anymore is only destroyed once the compositor released all of its buffers, so the range stays reserved until then
+	struct wl_list buffer_pools;
+};
+
+// shared by all surfaces with the same scaled dimensions, so every output of that size costs one draw per update
+struct wob_buffer_pool {
 	struct wob_dimensions dimensions;
-	uint32_t *shm_data;
+	// selects the packed colors written into the buffers
+	enum wob_pixel_format format;
+	struct wob_buffer buffers[WOB_BUFFER_POOL_SIZE];
+	// buffer drawn most recently, attached as is by the other surfaces that want the same content
+	struct wob_buffer *last_drawn;
+	struct wob_shm_pool *shm_pool;
+	size_t offset;
+	size_t size;
+	unsigned long refcount;
+	struct wl_list link;
+};
+
+struct wob_frame {
+	struct wp_presentation_feedback *feedback;
+	struct wob_latency *latency;
+	struct wob_frame_timing timing;
+	struct wl_list link;
+};
+
+struct wob_solid_part {
+	struct wl_surface *wl_surface;
+	struct wl_subsurface *wl_subsurface;
+	struct wp_viewport *wp_viewport;
+	// committed position and size, in surface local coordinates
+	struct wob_image_rect rect;
+	bool mapped;
 };
 
 struct wob_surface {
+	struct wob *app;
+	// output the surface is bound to, NULL when the compositor places it on the focused one
+	struct wob_output *output;
+	struct wl_list link;
+
 	struct zwlr_layer_surface_v1 *wlr_layer_surface;
 	struct wl_surface *wl_surface;
 	struct wp_fractional_scale_v1 *fractional;
@@ -34,12 +102,57 @@ struct wob_surface {
 	struct wob_dimensions dimensions;
 	struct wob_margin margin;
 	enum wob_anchor anchor;
-	struct wob_buffer *wob_buffer;
+	struct wob_buffer_pool *buffer_pool;
 	uint32_t scale;
+	enum wob_render_mode render_mode;
+
+	// render_mode = subsurface, fully filled bar that is cropped by its viewport to the current value
+	struct wl_surface *bar_wl_surface;
+	struct wl_subsurface *bar_subsurface;
+	struct wp_viewport *bar_viewport;
+	struct wob_buffer_pool *bar_buffer_pool;
+	struct wob_buffer *bar_buffer;
+	bool bar_mapped;
+
+	// render_mode = solid, every part of the image is a subsurface showing a scaled single pixel buffer
+	struct wob_solid_part solid_parts[WOB_IMAGE_PARTS_COUNT];
+	// indexed by enum wob_image_color
+	struct wl_buffer *solid_buffers[3];
+	struct wl_buffer *solid_transparent_buffer;
+
+	// surface was configured with these (scaled) dimensions, configure event renders only when they change
+	bool configured;
+	struct wob_dimensions configured_dimensions;
+	// unmapped on timeout by hide_mode = unmap, buffers and their content are kept for the next show
+	bool hidden;
+	// when the surface was asked to show up, for measuring the latency of the first visible frame
+	bool show_pending;
+	struct timespec show_requested;
+
+	struct wob_latency *latency;
+	// committed frames the compositor hasn't reported as presented or discarded yet
+	struct wl_list frames;
+	// when the input behind the desired state was read and when the current render started
+	struct timespec desired_input_time;
+	struct timespec render_start;
+	// at most one frame callback is in flight, inputs received meanwhile only update desired state
+	struct wl_callback *frame_callback;
+	// desired state differs from the last rendered frame
+	bool dirty;
+	// frame is waiting for the compositor to release one of the buffers
+	bool render_pending;
+	// what the compositor currently shows, damage is computed against it
+	bool committed;
+	struct wob_colors committed_colors;
+	size_t committed_bar_length;
 
 	// TODO move somewhere?
 	double desired_percentage;
 	struct wob_colors desired_colors;
+	// while running, desired_percentage is stepped towards the received value on every frame callback
+	struct wob_animation animation;
+	// desired state is a step of the animation, not a received value, so its frame is left out of latency feedback
+	bool animation_frame;
 };
 
 struct wob_output {
@@ -48,13 +161,36 @@ struct wob_output {
 	struct wl_list link;
 	struct wl_output *wl_output;
 	uint32_t wl_name;
+	// name and description are known, output config can be matched
+	bool done;
+	// matched output config, NULL if none matches; cleared whenever name or description change
+	struct wob_output_config *config;
+	bool config_resolved;
 };
 
 struct wob {
 	struct wl_list wob_outputs;
 	struct wob_config *config;
-	struct wob_surface *surface;
-	int shmid;
+	// one surface per output with output_mode = all or whitelist, at most one otherwise
+	struct wl_list surfaces;
+	struct wob_shm_pool shm_pool;
+	struct wob_shm_pool bar_shm_pool;
+	// full redraws copy the cached chrome and only fill the bar
+	struct wob_image_cache image_cache;
+	enum wob_render_mode render_mode;
+	// format of every drawn buffer, picked once the wl_shm formats are known
+	enum wob_pixel_format pixel_format;
+	struct wob_input input;
+	// files watched for values, see [source.*] in wob.ini(5)
+	struct wob_source *sources;
+	size_t sources_count;
+	int source_watch_fd;
+	// armed whenever a value is shown, the bar hides when it expires
+	int hide_timer_fd;
+	struct wob_latency latency;
+	unsigned long inputs;
+	// inputs that were superseded by a newer one before they got rendered
+	unsigned long coalesced_inputs;
 };
 
 struct managers {
@@ -62,7 +198,14 @@ struct managers {
 	struct wp_fractional_scale_manager_v1 *wp_fractional_scale;
 	struct zwlr_layer_shell_v1 *wlr_layer_shell;
 	struct wp_viewporter *wp_viewporter;
+	struct wl_subcompositor *wl_subcompositor;
+	struct wp_single_pixel_buffer_manager_v1 *wp_single_pixel_buffer;
+	struct wp_presentation *wp_presentation;
+	// all latency timestamps are taken with the clock the compositor reports presentation times in
+	clockid_t presentation_clock;
 	struct wl_shm *wl_shm;
+	// bit per enum wob_pixel_format the compositor announced with wl_shm.format
+	uint32_t shm_formats;
 };
 static struct managers managers;
 
@@ -94,132 +237,707 @@ wob_anchor_to_wlr_layer_surface_anchor(enum wob_anchor wob_anchor)
 
 static struct wl_callback_listener wl_surface_frame_listener;
 
-struct wob_buffer *
-wob_buffer_create_argb8888(int shmid, const struct wob_dimensions dimensions)
+void
+wp_presentation_handle_clock_id(void *data, struct wp_presentation *wp_presentation, uint32_t clk_id)
+{
+	(void) data;
+	(void) wp_presentation;
+
+	managers.presentation_clock = clk_id;
+}
+
+void
+wp_presentation_feedback_presented(
+	void *data,
+	struct wp_presentation_feedback *wp_presentation_feedback,
+	uint32_t tv_sec_hi,
+	uint32_t tv_sec_lo,
+	uint32_t tv_nsec,
+	uint32_t refresh,
+	uint32_t seq_hi,
+	uint32_t seq_lo,
+	uint32_t flags
+)
+{
+	(void) refresh;
+	(void) seq_hi;
+	(void) seq_lo;
+	(void) flags;
+
+	struct wob_frame *frame = data;
+	struct timespec presented = {
+		.tv_sec = (time_t) (((uint64_t) tv_sec_hi << 32) | tv_sec_lo),
+		.tv_nsec = tv_nsec,
+	};
+
+	wob_latency_record_presented(frame->latency, &frame->timing, presented);
+	wob_log_debug("frame presented %ju us after input", (uintmax_t) wob_latency_elapsed_usec(frame->timing.input, presented));
+
+	wp_presentation_feedback_destroy(wp_presentation_feedback);
+	wl_list_remove(&frame->link);
+	free(frame);
+}
+
+void
+wp_presentation_feedback_discarded(void *data, struct wp_presentation_feedback *wp_presentation_feedback)
 {
+	struct wob_frame *frame = data;
+	wob_latency_record_discarded(frame->latency);
+
+	wp_presentation_feedback_destroy(wp_presentation_feedback);
+	wl_list_remove(&frame->link);
+	free(frame);
+}
+
+void
+wob_surface_commit(struct wob_surface *surface)
+{
+	static const struct wp_presentation_feedback_listener wp_presentation_feedback_listener = {
+		.sync_output = noop,
+		.presented = wp_presentation_feedback_presented,
+		.discarded = wp_presentation_feedback_discarded,
+	};
+
+	// placeholder commits don't show any input and animation steps show values in between, they would only skew the numbers
+	bool placeholder = surface->dimensions.height == 1 && surface->dimensions.width == 1;
+	if (managers.wp_presentation == NULL || placeholder || surface->animation_frame) {
+		wl_surface_commit(surface->wl_surface);
+		return;
+	}
+
+	struct wob_frame *frame = calloc(1, sizeof(struct wob_frame));
+	if (frame == NULL) {
+		wob_log_panic("calloc failed");
+	}
+
+	frame->latency = surface->latency;
+	frame->timing.input = surface->desired_input_time;
+	frame->timing.render_start = surface->render_start;
+	clock_gettime(managers.presentation_clock, &frame->timing.render_end);
+
+	// feedback applies to the next commit
+	frame->feedback = wp_presentation_feedback(managers.wp_presentation, surface->wl_surface);
+	if (frame->feedback == NULL) {
+		wob_log_panic("wp_presentation_feedback failed");
+	}
+	wp_presentation_feedback_add_listener(frame->feedback, &wp_presentation_feedback_listener, frame);
+	wl_list_insert(&surface->frames, &frame->link);
+
+	wl_surface_commit(surface->wl_surface);
+	clock_gettime(managers.presentation_clock, &frame->timing.commit);
+}
+
+bool
+wob_buffer_pool_busy(struct wob_buffer_pool *pool)
+{
+	for (size_t i = 0; i < WOB_BUFFER_POOL_SIZE; ++i) {
+		if (pool->buffers[i].busy) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+wob_buffer_pool_destroy(struct wob_buffer_pool *pool)
+{
+	// compositor keeps the last attached content even after the wl_buffer is gone, the shm range is reused by the next pool
+	for (size_t i = 0; i < WOB_BUFFER_POOL_SIZE; ++i) {
+		wl_buffer_destroy(pool->buffers[i].wl_buffer);
+	}
+	wl_list_remove(&pool->link);
+	free(pool);
+}
+
+void
+wob_buffer_release(void *data, struct wl_buffer *wl_buffer)
+{
+	(void) wl_buffer;
+
+	struct wob_buffer *buffer = data;
+	buffer->busy = false;
+
+	struct wob_buffer_pool *pool = buffer->pool;
+	if (pool->refcount == 0 && !wob_buffer_pool_busy(pool)) {
+		wob_buffer_pool_destroy(pool);
+	}
+}
+
+uint32_t
+wob_pixel_format_to_wl_shm(enum wob_pixel_format format)
+{
+	switch (format) {
+		case WOB_PIXEL_FORMAT_ARGB8888:
+			return WL_SHM_FORMAT_ARGB8888;
+		case WOB_PIXEL_FORMAT_XRGB8888:
+			return WL_SHM_FORMAT_XRGB8888;
+		case WOB_PIXEL_FORMAT_RGB565:
+			return WL_SHM_FORMAT_RGB565;
+	}
+
+	return WL_SHM_FORMAT_ARGB8888;
+}
+
+struct wob_buffer_pool *
+wob_buffer_pool_create(struct wob_shm_pool *shm_pool, const struct wob_dimensions dimensions, enum wob_pixel_format format)
+{
+	static const struct wl_buffer_listener wl_buffer_listener = {
+		.release = wob_buffer_release,
+	};
+
 	size_t width = dimensions.width;
 	size_t height = dimensions.height;
-	size_t shm_size = width * height * 4;
+	size_t stride = width * wob_pixel_format_bytes(format);
+	// 16-bit buffers are padded, so every buffer starts aligned for the 32-bit fills
+	size_t buffer_size = (stride * height + 3) & ~(size_t) 3;
+	size_t pool_size = buffer_size * WOB_BUFFER_POOL_SIZE;
+
+	// first gap between live pools that fits, end of the shm otherwise
+	size_t offset = 0;
+	struct wl_list *position = &shm_pool->buffer_pools;
+	struct wob_buffer_pool *other;
+	wl_list_for_each (other, &shm_pool->buffer_pools, link) {
+		if (other->offset - offset >= pool_size) {
+			break;
+		}
+		offset = other->offset + other->size;
+		position = &other->link;
+	}
 
-	void *shm_data = wob_shm_allocate(shmid, shm_size);
-	if (shm_data == NULL) {
-		wob_log_panic("wob_shm_allocate() failed");
+	size_t previous_shm_size = shm_pool->shm.size;
+	void *previous_shm_data = shm_pool->shm.data;
+	if (!wob_shm_reserve(&shm_pool->shm, offset + pool_size)) {
+		wob_log_panic("wob_shm_reserve() failed");
 	}
 
-	struct wl_shm_pool *pool = wl_shm_create_pool(managers.wl_shm, shmid, shm_size);
-	if (pool == NULL) {
-		wob_log_panic("wl_shm_create_pool failed");
+	if (shm_pool->wl_shm_pool == NULL) {
+		shm_pool->wl_shm_pool = wl_shm_create_pool(managers.wl_shm, shm_pool->shm.fd, shm_pool->shm.size);
+		if (shm_pool->wl_shm_pool == NULL) {
+			wob_log_panic("wl_shm_create_pool failed");
+		}
+	}
+	else if (shm_pool->shm.size > previous_shm_size) {
+		wl_shm_pool_resize(shm_pool->wl_shm_pool, shm_pool->shm.size);
 	}
 
-	struct wl_buffer *wl_buffer = wl_shm_pool_create_buffer(pool, 0, width, height, width * 4, WL_SHM_FORMAT_ARGB8888);
-	if (wl_buffer == NULL) {
-		wob_log_panic("wl_shm_pool_create_buffer failed");
+	// growing the shm may have moved the mapping under the live pools
+	if (shm_pool->shm.data != previous_shm_data) {
+		wl_list_for_each (other, &shm_pool->buffer_pools, link) {
+			size_t other_buffer_size = other->size / WOB_BUFFER_POOL_SIZE;
+			for (size_t i = 0; i < WOB_BUFFER_POOL_SIZE; ++i) {
+				other->buffers[i].shm_data = (char *) shm_pool->shm.data + other->offset + i * other_buffer_size;
+			}
+		}
 	}
-	wl_shm_pool_destroy(pool);
 
-	struct wob_buffer *wob_buffer = calloc(1, sizeof(struct wob_buffer));
-	if (wob_buffer == NULL) {
+	struct wob_buffer_pool *pool = calloc(1, sizeof(struct wob_buffer_pool));
+	if (pool == NULL) {
 		wob_log_panic("calloc failed");
 	}
 
-	*wob_buffer = (struct wob_buffer) {
-		.wl_buffer = wl_buffer,
-		.dimensions = dimensions,
-		.shm_data = shm_data,
-	};
+	pool->dimensions = dimensions;
+	pool->format = format;
+	pool->shm_pool = shm_pool;
+	pool->offset = offset;
+	pool->size = pool_size;
+	pool->refcount = 1;
+	pool->last_drawn = NULL;
+	wl_list_insert(position, &pool->link);
+
+	for (size_t i = 0; i < WOB_BUFFER_POOL_SIZE; ++i) {
+		struct wl_buffer *wl_buffer = wl_shm_pool_create_buffer(shm_pool->wl_shm_pool, offset + i * buffer_size, width, height, stride, wob_pixel_format_to_wl_shm(format));
+		if (wl_buffer == NULL) {
+			wob_log_panic("wl_shm_pool_create_buffer failed");
+		}
+
+		struct wob_buffer *buffer = &pool->buffers[i];
+		*buffer = (struct wob_buffer) {
+			.wl_buffer = wl_buffer,
+			.shm_data = (char *) shm_pool->shm.data + offset + i * buffer_size,
+			.busy = false,
+			.drawn = false,
+			.pool = pool,
+		};
+		wl_buffer_add_listener(wl_buffer, &wl_buffer_listener, buffer);
+	}
+
+	wob_log_debug("created buffer pool of %d %s buffers %zu x %zu at offset %zu", WOB_BUFFER_POOL_SIZE, wob_pixel_format_name(format), width, height, offset);
 
-	wob_log_debug("created buffer %zu x %zu", width, height);
+	return pool;
+}
+
+struct wob_buffer_pool *
+wob_buffer_pool_get(struct wob_shm_pool *shm_pool, const struct wob_dimensions dimensions, enum wob_pixel_format format)
+{
+	struct wob_buffer_pool *pool;
+	// pool waiting for its buffers to be released is taken over as is
+	wl_list_for_each (pool, &shm_pool->buffer_pools, link) {
+		if (pool->format == format && wob_dimensions_eq(pool->dimensions, dimensions)) {
+			pool->refcount += 1;
+			return pool;
+		}
+	}
+
+	return wob_buffer_pool_create(shm_pool, dimensions, format);
+}
+
+struct wob_buffer *
+wob_buffer_pool_acquire(struct wob_buffer_pool *pool)
+{
+	for (size_t i = 0; i < WOB_BUFFER_POOL_SIZE; ++i) {
+		if (!pool->buffers[i].busy) {
+			return &pool->buffers[i];
+		}
+	}
+
+	return NULL;
+}
+
+struct wob_buffer *
+wob_buffer_pool_find_drawn(struct wob_buffer_pool *pool, struct wob_colors colors, size_t bar_length)
+{
+	// attaching a buffer the compositor already holds for another surface is fine, it's never written while busy
+	struct wob_buffer *buffer = pool->last_drawn;
+	if (buffer != NULL && buffer->drawn && buffer->bar_length == bar_length && wob_colors_eq(buffer->colors, colors)) {
+		return buffer;
+	}
 
-	return wob_buffer;
+	return NULL;
 }
 
 void
-wob_buffer_destroy(struct wob_buffer *buffer)
+wob_buffer_pool_unref(struct wob_buffer_pool *pool)
 {
-	wl_buffer_destroy(buffer->wl_buffer);
-	if (buffer->shm_data != NULL) {
-		munmap(buffer->shm_data, buffer->dimensions.width * buffer->dimensions.height * 4);
+	pool->refcount -= 1;
+	if (pool->refcount > 0) {
+		return;
+	}
+
+	// compositor may still be reading a busy buffer, its range can't be handed to a new pool before the release event
+	if (!wob_buffer_pool_busy(pool)) {
+		wob_buffer_pool_destroy(pool);
 	}
-	free(buffer);
+}
+
+bool
+wob_surface_render_buffer(struct wob_surface *surface)
+{
+	// redraw only if we have dimensions set, otherwise keep the transparent pixel
+	bool placeholder = surface->dimensions.height == 1 && surface->dimensions.width == 1;
+
+	struct wob_buffer_pool *pool = surface->buffer_pool;
+	struct wob_dimensions dimensions = pool->dimensions;
+	size_t bar_length = placeholder ? 0 : wob_image_bar_length(dimensions, surface->desired_percentage);
+	struct wob_packed_colors pixels = surface->desired_colors.packed[pool->format];
+
+	struct wob_buffer *buffer = placeholder ? NULL : wob_buffer_pool_find_drawn(pool, surface->desired_colors, bar_length);
+	if (buffer == NULL) {
+		buffer = wob_buffer_pool_acquire(pool);
+		if (buffer == NULL) {
+			wob_log_debug("all buffers are held by compositor, postponing frame");
+			surface->render_pending = true;
+			return false;
+		}
+
+		if (!placeholder) {
+			if (buffer->drawn && wob_colors_eq(buffer->colors, surface->desired_colors)) {
+				wob_image_draw_bar_delta(buffer->shm_data, dimensions, pool->format, pixels, buffer->bar_length, bar_length);
+			}
+			else {
+				wob_image_cache_draw(&surface->app->image_cache, buffer->shm_data, dimensions, pool->format, pixels, bar_length);
+			}
+			buffer->drawn = true;
+			buffer->colors = surface->desired_colors;
+			buffer->bar_length = bar_length;
+			pool->last_drawn = buffer;
+		}
+	}
+
+	wl_surface_attach(surface->wl_surface, buffer->wl_buffer, 0, 0);
+	if (!placeholder && surface->committed && wob_colors_eq(surface->committed_colors, surface->desired_colors)) {
+		struct wob_image_rect damage = wob_image_bar_delta(dimensions, surface->committed_bar_length, bar_length);
+		if (damage.width > 0 && damage.height > 0) {
+			wl_surface_damage_buffer(surface->wl_surface, damage.x, damage.y, damage.width, damage.height);
+		}
+	}
+	else {
+		wl_surface_damage_buffer(surface->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+	}
+	wob_surface_commit(surface);
+
+	surface->committed = !placeholder;
+	surface->committed_colors = surface->desired_colors;
+	surface->committed_bar_length = bar_length;
+	buffer->busy = true;
+	surface->render_pending = false;
+	surface->dirty = false;
+
+	return true;
+}
+
+bool
+wob_surface_render_subsurface(struct wob_surface *surface)
+{
+	struct wob_dimensions dimensions = surface->buffer_pool->dimensions;
+
+	// frame and fully filled bar are drawn only when colors or dimensions change, and only by the first surface of that size
+	if (!surface->committed || !wob_colors_eq(surface->committed_colors, surface->desired_colors)) {
+		struct wob_buffer *drawn_frame_buffer = wob_buffer_pool_find_drawn(surface->buffer_pool, surface->desired_colors, 0);
+		struct wob_buffer *drawn_bar_buffer = wob_buffer_pool_find_drawn(surface->bar_buffer_pool, surface->desired_colors, 0);
+		struct wob_buffer *frame_buffer = drawn_frame_buffer != NULL ? drawn_frame_buffer : wob_buffer_pool_acquire(surface->buffer_pool);
+		struct wob_buffer *bar_buffer = drawn_bar_buffer != NULL ? drawn_bar_buffer : wob_buffer_pool_acquire(surface->bar_buffer_pool);
+		if (frame_buffer == NULL || bar_buffer == NULL) {
+			wob_log_debug("all buffers are held by compositor, postponing frame");
+			surface->render_pending = true;
+			return false;
+		}
+
+		if (drawn_frame_buffer == NULL) {
+			enum wob_pixel_format format = surface->buffer_pool->format;
+			wob_image_cache_draw(&surface->app->image_cache, frame_buffer->shm_data, dimensions, format, surface->desired_colors.packed[format], 0);
+			frame_buffer->drawn = true;
+			frame_buffer->colors = surface->desired_colors;
+			frame_buffer->bar_length = 0;
+			surface->buffer_pool->last_drawn = frame_buffer;
+		}
+		if (drawn_bar_buffer == NULL) {
+			struct wob_dimensions bar_dimensions = surface->bar_buffer_pool->dimensions;
+			enum wob_pixel_format format = surface->bar_buffer_pool->format;
+			wob_image_fill(bar_buffer->shm_data, bar_dimensions.width, bar_dimensions.height, format, surface->desired_colors.packed[format].value);
+			bar_buffer->drawn = true;
+			bar_buffer->colors = surface->desired_colors;
+			bar_buffer->bar_length = 0;
+			surface->bar_buffer_pool->last_drawn = bar_buffer;
+		}
+
+		wl_surface_attach(surface->wl_surface, frame_buffer->wl_buffer, 0, 0);
+		wl_surface_damage_buffer(surface->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+		frame_buffer->busy = true;
+
+		surface->bar_buffer = bar_buffer;
+		surface->bar_mapped = false;
+	}
+
+	// everything below is in surface local coordinates, bar length is rounded to whole logical pixels
+	size_t offset = surface->dimensions.border_offset + surface->dimensions.border_size + surface->dimensions.bar_padding;
+	size_t bar_width = surface->dimensions.width - 2 * offset;
+	size_t bar_height = surface->dimensions.height - 2 * offset;
+	size_t bar_length = wob_image_bar_length(surface->dimensions, surface->desired_percentage);
+
+	if (bar_length == 0) {
+		// viewport destination can't be empty, unmap the bar instead
+		wl_surface_attach(surface->bar_wl_surface, NULL, 0, 0);
+		surface->bar_mapped = false;
+	}
+	else {
+		if (!surface->bar_mapped) {
+			wl_surface_attach(surface->bar_wl_surface, surface->bar_buffer->wl_buffer, 0, 0);
+			wl_surface_damage_buffer(surface->bar_wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+			surface->bar_buffer->busy = true;
+			surface->bar_mapped = true;
+		}
+
+		// crop the source proportionally, so the bar is sampled 1:1 and not stretched
+		struct wob_dimensions bar_dimensions = surface->bar_buffer_pool->dimensions;
+		double source_width = bar_dimensions.width;
+		double source_height = bar_dimensions.height;
+		size_t destination_width = bar_width;
+		size_t destination_height = bar_height;
+		size_t x = offset;
+		size_t y = offset;
+		switch (surface->dimensions.orientation) {
+			case WOB_ORIENTATION_HORIZONTAL:
+				source_width = source_width * bar_length / bar_width;
+				destination_width = bar_length;
+				break;
+			case WOB_ORIENTATION_VERTICAL:
+				source_height = source_height * bar_length / bar_height;
+				destination_height = bar_length;
+				y += bar_height - bar_length;
+				break;
+		}
+
+		// source rectangle must never reach outside of the buffer, so the offset is derived from the rounded height
+		wl_fixed_t source_fixed_height = wl_fixed_from_double(source_height);
+		wp_viewport_set_source(
+			surface->bar_viewport,
+			wl_fixed_from_int(0),
+			wl_fixed_from_int(bar_dimensions.height) - source_fixed_height,
+			wl_fixed_from_double(source_width),
+			source_fixed_height
+		);
+		wp_viewport_set_destination(surface->bar_viewport, destination_width, destination_height);
+		wl_subsurface_set_position(surface->bar_subsurface, x, y);
+	}
+
+	// bar is a synchronized subsurface, its state is applied together with the parent commit
+	wl_surface_commit(surface->bar_wl_surface);
+	wob_surface_commit(surface);
+
+	surface->committed = true;
+	surface->committed_colors = surface->desired_colors;
+	surface->render_pending = false;
+	surface->dirty = false;
+
+	return true;
+}
+
+struct wl_buffer *
+wob_solid_buffer_create(struct wob_color color)
+{
+	// single pixel buffer takes premultiplied channels scaled to the whole uint32_t range
+	struct wob_color premultiplied = wob_color_premultiply_alpha(color);
+	struct wl_buffer *wl_buffer = wp_single_pixel_buffer_manager_v1_create_u32_rgba_buffer(
+		managers.wp_single_pixel_buffer,
+		(uint32_t) ((double) premultiplied.r * UINT32_MAX),
+		(uint32_t) ((double) premultiplied.g * UINT32_MAX),
+		(uint32_t) ((double) premultiplied.b * UINT32_MAX),
+		(uint32_t) ((double) premultiplied.a * UINT32_MAX)
+	);
+	if (wl_buffer == NULL) {
+		wob_log_panic("wp_single_pixel_buffer_manager_v1_create_u32_rgba_buffer failed");
+	}
+
+	return wl_buffer;
+}
+
+bool
+wob_surface_render_solid(struct wob_surface *surface)
+{
+	bool placeholder = surface->dimensions.height == 1 && surface->dimensions.width == 1;
+
+	// main surface only maps the whole area with a transparent pixel, the parts are its subsurfaces
+	if (!surface->committed) {
+		wl_surface_attach(surface->wl_surface, surface->solid_transparent_buffer, 0, 0);
+		wl_surface_damage_buffer(surface->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+	}
+
+	struct wl_buffer *previous_buffers[3] = {NULL};
+	bool colors_changed = !surface->committed || !wob_colors_eq(surface->committed_colors, surface->desired_colors);
+	if (colors_changed) {
+		memcpy(previous_buffers, surface->solid_buffers, sizeof(previous_buffers));
+		surface->solid_buffers[WOB_IMAGE_COLOR_BACKGROUND] = wob_solid_buffer_create(surface->desired_colors.background);
+		surface->solid_buffers[WOB_IMAGE_COLOR_BORDER] = wob_solid_buffer_create(surface->desired_colors.border);
+		surface->solid_buffers[WOB_IMAGE_COLOR_VALUE] = wob_solid_buffer_create(surface->desired_colors.value);
+	}
+
+	// everything is in surface local coordinates, edges are rounded to whole logical pixels
+	struct wob_image_part parts[WOB_IMAGE_PARTS_COUNT] = {0};
+	size_t bar_length = 0;
+	if (!placeholder) {
+		bar_length = wob_image_bar_length(surface->dimensions, surface->desired_percentage);
+		wob_image_layout(surface->dimensions, bar_length, parts);
+	}
+
+	for (size_t i = 0; i < WOB_IMAGE_PARTS_COUNT; ++i) {
+		struct wob_solid_part *part = &surface->solid_parts[i];
+		struct wob_image_rect rect = parts[i].rect;
+
+		// viewport destination can't be empty, unmap the part instead
+		if (rect.width == 0 || rect.height == 0) {
+			if (part->mapped) {
+				wl_surface_attach(part->wl_surface, NULL, 0, 0);
+				wl_surface_commit(part->wl_surface);
+				part->mapped = false;
+			}
+			continue;
+		}
+
+		bool changed = false;
+		if (!part->mapped || colors_changed) {
+			wl_surface_attach(part->wl_surface, surface->solid_buffers[parts[i].color], 0, 0);
+			wl_surface_damage_buffer(part->wl_surface, 0, 0, 1, 1);
+			part->mapped = true;
+			changed = true;
+		}
+		if (changed || !wob_image_rect_eq(part->rect, rect)) {
+			wp_viewport_set_destination(part->wp_viewport, rect.width, rect.height);
+			wl_subsurface_set_position(part->wl_subsurface, rect.x, rect.y);
+			part->rect = rect;
+			changed = true;
+		}
+
+		if (changed) {
+			wl_surface_commit(part->wl_surface);
+		}
+	}
+
+	// parts are synchronized subsurfaces, their state is applied together with the parent commit
+	wob_surface_commit(surface);
+
+	// compositor keeps the last attached content even after the wl_buffer is gone
+	for (size_t i = 0; i < 3; ++i) {
+		if (previous_buffers[i] != NULL) {
+			wl_buffer_destroy(previous_buffers[i]);
+		}
+	}
+
+	surface->committed = !placeholder;
+	surface->committed_colors = surface->desired_colors;
+	surface->committed_bar_length = bar_length;
+	surface->render_pending = false;
+	surface->dirty = false;
+
+	return true;
+}
+
+bool
+wob_surface_render(struct wob_surface *surface)
+{
+	// surface without dimensions only shows the transparent placeholder buffer
+	bool placeholder = surface->dimensions.height == 1 && surface->dimensions.width == 1;
+
+	clock_gettime(managers.presentation_clock, &surface->render_start);
+
+	bool rendered;
+	if (surface->render_mode == WOB_RENDER_MODE_SOLID) {
+		rendered = wob_surface_render_solid(surface);
+	}
+	else if (placeholder || surface->render_mode == WOB_RENDER_MODE_BUFFER) {
+		rendered = wob_surface_render_buffer(surface);
+	}
+	else {
+		rendered = wob_surface_render_subsurface(surface);
+	}
+
+	if (rendered && !placeholder && surface->show_pending) {
+		struct timespec now;
+		clock_gettime(managers.presentation_clock, &now);
+		wob_log_info("First frame committed %ju us after the bar was requested to show", (uintmax_t) wob_latency_elapsed_usec(surface->show_requested, now));
+		surface->show_pending = false;
+	}
+
+	return rendered;
 }
 
 void
 layer_surface_configure(void *data, struct zwlr_layer_surface_v1 *zwlr_surface, uint32_t serial, uint32_t w, uint32_t h)
 {
-	struct wob *state = data;
+	struct wob_surface *surface = data;
+	struct wob *state = surface->app;
 
 	wob_log_debug("layer_surface_configure(%p, %u, %u, %u)", (void *) zwlr_surface, (uintmax_t) serial, w, h);
 
 	zwlr_layer_surface_v1_ack_configure(zwlr_surface, serial);
 
-	int shmid = state->shmid;
-	struct wob_surface *surface = state->surface;
-	if (surface == NULL) {
-		wob_log_panic("surface is NULL");
-	}
-
 	struct wob_dimensions scaled_dimensions = wob_dimensions_apply_scale(surface->dimensions, surface->scale);
-	if (surface->wob_buffer == NULL || !wob_dimensions_eq(surface->wob_buffer->dimensions, scaled_dimensions)) {
-		if (surface->wob_buffer != NULL) {
-			wob_buffer_destroy(surface->wob_buffer);
+	bool resized = !wob_dimensions_eq(surface->configured_dimensions, scaled_dimensions);
+	if (!surface->configured || resized) {
+		surface->configured = true;
+		surface->configured_dimensions = scaled_dimensions;
+		surface->committed = false;
+
+		// solid mode doesn't draw anything, so it doesn't need any shared memory
+		if (surface->render_mode != WOB_RENDER_MODE_SOLID && (surface->buffer_pool == NULL || resized)) {
+			if (surface->buffer_pool != NULL) {
+				wob_buffer_pool_unref(surface->buffer_pool);
+			}
+
+			// placeholder has to stay transparent, so it keeps the alpha channel
+			bool placeholder = surface->dimensions.height == 1 && surface->dimensions.width == 1;
+			enum wob_pixel_format format = placeholder ? WOB_PIXEL_FORMAT_ARGB8888 : state->pixel_format;
+			surface->buffer_pool = wob_buffer_pool_get(&state->shm_pool, scaled_dimensions, format);
 		}
-		surface->wob_buffer = wob_buffer_create_argb8888(shmid, scaled_dimensions);
 
-		// redraw only if we have dimensions set, otherwise keep the transparent pixel
-		if (surface->dimensions.height != 1 || surface->dimensions.width != 1) {
-			wob_image_draw(surface->wob_buffer->shm_data, surface->wob_buffer->dimensions, surface->desired_colors, surface->desired_percentage);
+		if (surface->bar_wl_surface != NULL && (surface->bar_buffer_pool == NULL || resized)) {
+			if (surface->bar_buffer_pool != NULL) {
+				wob_buffer_pool_unref(surface->bar_buffer_pool);
+			}
+
+			size_t offset = scaled_dimensions.border_offset + scaled_dimensions.border_size + scaled_dimensions.bar_padding;
+			struct wob_dimensions bar_dimensions = {
+				.width = scaled_dimensions.width > 2 * offset ? scaled_dimensions.width - 2 * offset : 1,
+				.height = scaled_dimensions.height > 2 * offset ? scaled_dimensions.height - 2 * offset : 1,
+				.orientation = scaled_dimensions.orientation,
+			};
+			surface->bar_buffer_pool = wob_buffer_pool_get(&state->bar_shm_pool, bar_dimensions, state->pixel_format);
+			surface->bar_buffer = NULL;
+			surface->bar_mapped = false;
 		}
 
 		if (surface->wp_viewport != NULL) {
 			wp_viewport_set_destination(surface->wp_viewport, surface->dimensions.width, surface->dimensions.height);
 		}
 
-		wl_surface_attach(surface->wl_surface, surface->wob_buffer->wl_buffer, 0, 0);
-		wl_surface_damage_buffer(surface->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
-		wl_surface_commit(surface->wl_surface);
+		// compositor may configure the surface right after it got unmapped, it's rendered once it should show up again
+		if (!surface->hidden) {
+			wob_surface_render(surface);
+		}
 	}
 }
 
-void
-layer_surface_enter(void *data, struct wl_surface *wl_surface, struct wl_output *entered_output)
+struct wob_output_config *
+wob_output_resolve_config(struct wob *app, struct wob_output *output)
 {
-	wob_log_debug("layer_surface_enter(%x)", wl_surface);
-	struct wob *app = data;
+	if (output->config_resolved) {
+		return output->config;
+	}
 
-	struct wob_output *selected_output;
-	wl_list_for_each (selected_output, &app->wob_outputs, link) {
-		if (entered_output == selected_output->wl_output) {
-			break;
-		}
+	// name takes precedence, description is the fallback
+	output->config = NULL;
+	if (output->name != NULL) {
+		output->config = wob_config_match_output(app->config, output->name);
 	}
+	if (output->config == NULL && output->description != NULL) {
+		output->config = wob_config_match_output(app->config, output->description);
+	}
+	output->config_resolved = true;
+
+	return output->config;
+}
+
+bool
+wob_surface_apply_output(struct wob_surface *surface, struct wob_output *output)
+{
+	struct wob *app = surface->app;
 
 	// defaults
 	struct wob_margin margin = app->config->margin;
 	struct wob_dimensions dimensions = app->config->dimensions;
 	enum wob_anchor anchor = app->config->anchor;
 
-	// try to match output config
-	struct wob_output_config *output_config = NULL;
-	if (selected_output->name != NULL) {
-		output_config = wob_config_match_output(app->config, selected_output->name);
-	}
-	if (output_config != NULL && selected_output->description != NULL) {
-		output_config = wob_config_match_output(app->config, selected_output->description);
-	}
-
+	struct wob_output_config *output_config = wob_output_resolve_config(app, output);
 	if (output_config != NULL) {
 		margin = output_config->margin;
 		dimensions = output_config->dimensions;
 		anchor = output_config->anchor;
 	}
 
-	struct wob_surface *surface = app->surface;
-	if (!wob_dimensions_eq(surface->dimensions, dimensions) || !wob_margin_eq(margin, surface->margin) || anchor != surface->anchor) {
-		zwlr_layer_surface_v1_set_anchor(surface->wlr_layer_surface, wob_anchor_to_wlr_layer_surface_anchor(anchor));
-		zwlr_layer_surface_v1_set_margin(surface->wlr_layer_surface, margin.top, margin.right, margin.bottom, margin.left);
-		zwlr_layer_surface_v1_set_size(surface->wlr_layer_surface, dimensions.width, dimensions.height);
+	if (wob_dimensions_eq(surface->dimensions, dimensions) && wob_margin_eq(margin, surface->margin) && anchor == surface->anchor) {
+		return false;
+	}
+
+	zwlr_layer_surface_v1_set_anchor(surface->wlr_layer_surface, wob_anchor_to_wlr_layer_surface_anchor(anchor));
+	zwlr_layer_surface_v1_set_margin(surface->wlr_layer_surface, margin.top, margin.right, margin.bottom, margin.left);
+	zwlr_layer_surface_v1_set_size(surface->wlr_layer_surface, dimensions.width, dimensions.height);
+
+	surface->dimensions = dimensions;
+	surface->margin = margin;
+	surface->anchor = anchor;
+
+	return true;
+}
+
+void
+layer_surface_enter(void *data, struct wl_surface *wl_surface, struct wl_output *entered_output)
+{
+	wob_log_debug("layer_surface_enter(%x)", wl_surface);
+	struct wob_surface *surface = data;
+
+	// surface bound to an output got its geometry on creation
+	if (surface->output != NULL) {
+		return;
+	}
+
+	struct wob_output *selected_output;
+	wl_list_for_each (selected_output, &surface->app->wob_outputs, link) {
+		if (entered_output == selected_output->wl_output) {
+			break;
+		}
+	}
 
-		surface->dimensions = dimensions;
+	if (wob_surface_apply_output(surface, selected_output)) {
 		wl_surface_commit(surface->wl_surface);
 	}
 
@@ -231,16 +949,14 @@ wp_fractional_scale_preferred_scale(void *data, struct wp_fractional_scale_v1 *w
 {
 	(void) wp_fractional_scale;
 
-	struct wob *app = data;
-
-	struct wob_surface *surface = app->surface;
+	struct wob_surface *surface = data;
 
 	wob_log_debug("setting fractional scale to %u", scale);
 	surface->scale = scale;
 }
 
 struct wob_surface *
-wob_create_surface(struct wob *app)
+wob_create_surface(struct wob *app, struct wob_output *output)
 {
 	static const struct zwlr_layer_surface_v1_listener zwlr_layer_surface_listener = {
 		.configure = layer_surface_configure,
@@ -265,18 +981,24 @@ wob_create_surface(struct wob *app)
 
 	struct wob_margin margin = {.top = 0, .right = 0, .bottom = 0, .left = 0};
 
+	struct wob_surface *rendered = calloc(1, sizeof(struct wob_surface));
+	if (rendered == NULL) {
+		wob_log_panic("calloc failed");
+	}
+
 	struct wl_surface *wl_surface = wl_compositor_create_surface(managers.wl_compositor);
 	if (wl_surface == NULL) {
 		wob_log_panic("wl_compositor_create_surface failed");
 	}
-	wl_surface_add_listener(wl_surface, &wl_surface_listener, app);
+	wl_surface_add_listener(wl_surface, &wl_surface_listener, rendered);
 
-	struct zwlr_layer_surface_v1 *wlr_layer_surface = zwlr_layer_shell_v1_get_layer_surface(managers.wlr_layer_shell, wl_surface, NULL, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, "wob");
+	struct wl_output *wl_output = output != NULL ? output->wl_output : NULL;
+	struct zwlr_layer_surface_v1 *wlr_layer_surface = zwlr_layer_shell_v1_get_layer_surface(managers.wlr_layer_shell, wl_surface, wl_output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, "wob");
 	if (wlr_layer_surface == NULL) {
 		wob_log_panic("wlr_layer_shell_v1_get_layer_surface failed");
 	}
 	zwlr_layer_surface_v1_set_size(wlr_layer_surface, dimensions.width, dimensions.height);
-	zwlr_layer_surface_v1_add_listener(wlr_layer_surface, &zwlr_layer_surface_listener, app);
+	zwlr_layer_surface_v1_add_listener(wlr_layer_surface, &zwlr_layer_surface_listener, rendered);
 
 	struct wp_viewport *wp_viewport = NULL;
 	if (managers.wp_viewporter != NULL) {
@@ -297,26 +1019,91 @@ wob_create_surface(struct wob *app)
 			wob_log_panic("wp_fractional_scale_manager_v1_get_fractional_scale failed");
 		}
 
-		wp_fractional_scale_v1_add_listener(wp_fractional, &wp_fractional_scale_listener, app);
+		wp_fractional_scale_v1_add_listener(wp_fractional, &wp_fractional_scale_listener, rendered);
 	}
 
-	struct wob_surface *rendered = calloc(1, sizeof(struct wob_surface));
-	if (rendered == NULL) {
-		wob_log_panic("calloc failed");
+	struct wl_surface *bar_wl_surface = NULL;
+	struct wl_subsurface *bar_subsurface = NULL;
+	struct wp_viewport *bar_viewport = NULL;
+	if (app->render_mode == WOB_RENDER_MODE_SUBSURFACE) {
+		bar_wl_surface = wl_compositor_create_surface(managers.wl_compositor);
+		if (bar_wl_surface == NULL) {
+			wob_log_panic("wl_compositor_create_surface failed");
+		}
+
+		bar_subsurface = wl_subcompositor_get_subsurface(managers.wl_subcompositor, bar_wl_surface, wl_surface);
+		if (bar_subsurface == NULL) {
+			wob_log_panic("wl_subcompositor_get_subsurface failed");
+		}
+
+		bar_viewport = wp_viewporter_get_viewport(managers.wp_viewporter, bar_wl_surface);
+		if (bar_viewport == NULL) {
+			wob_log_panic("wp_viewporter_get_viewport failed");
+		}
+	}
+
+	struct wob_solid_part solid_parts[WOB_IMAGE_PARTS_COUNT] = {0};
+	struct wl_buffer *solid_transparent_buffer = NULL;
+	if (app->render_mode == WOB_RENDER_MODE_SOLID) {
+		for (size_t i = 0; i < WOB_IMAGE_PARTS_COUNT; ++i) {
+			struct wob_solid_part *part = &solid_parts[i];
+			part->wl_surface = wl_compositor_create_surface(managers.wl_compositor);
+			if (part->wl_surface == NULL) {
+				wob_log_panic("wl_compositor_create_surface failed");
+			}
+
+			part->wl_subsurface = wl_subcompositor_get_subsurface(managers.wl_subcompositor, part->wl_surface, wl_surface);
+			if (part->wl_subsurface == NULL) {
+				wob_log_panic("wl_subcompositor_get_subsurface failed");
+			}
+
+			part->wp_viewport = wp_viewporter_get_viewport(managers.wp_viewporter, part->wl_surface);
+			if (part->wp_viewport == NULL) {
+				wob_log_panic("wp_viewporter_get_viewport failed");
+			}
+		}
+
+		solid_transparent_buffer = wob_solid_buffer_create((struct wob_color) {.a = 0, .r = 0, .g = 0, .b = 0});
 	}
 
 	*rendered = (struct wob_surface) {
+		.app = app,
+		.output = output,
 		.wlr_layer_surface = wlr_layer_surface,
 		.wl_surface = wl_surface,
 		.dimensions = dimensions,
 		.scale = 120,
-		.wob_buffer = NULL,
+		.buffer_pool = NULL,
+		.frame_callback = NULL,
+		.dirty = false,
+		.render_pending = false,
+		.committed = false,
 		.margin = margin,
 		.anchor = 0,
 		.wp_viewport = wp_viewport,
 		.fractional = wp_fractional,
+		.render_mode = app->render_mode,
+		.bar_wl_surface = bar_wl_surface,
+		.bar_subsurface = bar_subsurface,
+		.bar_viewport = bar_viewport,
+		.bar_buffer_pool = NULL,
+		.bar_buffer = NULL,
+		.bar_mapped = false,
+		.solid_transparent_buffer = solid_transparent_buffer,
+		.configured = false,
+		// shown explicitly by wob_surface_show()
+		.hidden = true,
+		.latency = &app->latency,
 	};
+	memcpy(rendered->solid_parts, solid_parts, sizeof(solid_parts));
+	wl_list_init(&rendered->frames);
+
+	// output is known upfront, so the surface starts with its real size instead of the placeholder
+	if (output != NULL) {
+		wob_surface_apply_output(rendered, output);
+	}
 
+	wl_list_insert(app->surfaces.prev, &rendered->link);
 	wl_surface_commit(wl_surface);
 
 	return rendered;
@@ -325,23 +1112,135 @@ wob_create_surface(struct wob *app)
 void
 wl_surface_frame_done(void *data, struct wl_callback *cb, uint32_t time)
 {
-	(void) time;
-
 	wl_callback_destroy(cb);
 
 	struct wob_surface *surface = data;
+	surface->frame_callback = NULL;
+
+	if (surface->animation.running) {
+		struct wob_config *config = surface->app->config;
+		surface->desired_percentage = wob_animation_step(&surface->animation, config->animation_curve, config->animation_duration_msec, time);
+		surface->animation_frame = true;
+		surface->dirty = true;
+
+		// next step rides on the commit of this one, a settled animation stops asking for frames
+		if (surface->animation.running) {
+			surface->frame_callback = wl_surface_frame(surface->wl_surface);
+			wl_callback_add_listener(surface->frame_callback, &wl_surface_frame_listener, surface);
+		}
+	}
+
+	if (!surface->dirty) {
+		return;
+	}
+
 	wob_log_debug("rendering frame");
+	wob_surface_render(surface);
+}
+
+bool
+wob_surface_schedule_frame(struct wob_surface *surface)
+{
+	// previous desired state was never rendered, caller counts it as coalesced
+	bool coalesced = surface->dirty;
+	surface->dirty = true;
+
+	// frame is already scheduled, it will pick up the latest desired state
+	if (surface->frame_callback != NULL) {
+		return coalesced;
+	}
+
+	// surface was not configured yet, configure event will render it
+	if (!surface->configured) {
+		return coalesced;
+	}
+
+	surface->frame_callback = wl_surface_frame(surface->wl_surface);
+	wl_callback_add_listener(surface->frame_callback, &wl_surface_frame_listener, surface);
+	wl_surface_commit(surface->wl_surface);
 
-	wob_image_draw(surface->wob_buffer->shm_data, surface->wob_buffer->dimensions, surface->desired_colors, surface->desired_percentage);
+	return coalesced;
+}
+
+void
+wob_surface_hide(struct wob_surface *surface)
+{
+	// frame callbacks of an unmapped surface are not guaranteed to ever fire
+	if (surface->frame_callback != NULL) {
+		wl_callback_destroy(surface->frame_callback);
+		surface->frame_callback = NULL;
+	}
+
+	wl_surface_attach(surface->wl_surface, NULL, 0, 0);
+	wl_surface_commit(surface->wl_surface);
+
+	// animation can't continue without frame callbacks, showing again starts at its target
+	if (surface->animation.running) {
+		surface->desired_percentage = surface->animation.to;
+		surface->animation = (struct wob_animation) {0};
+		surface->animation_frame = false;
+	}
+
+	// layer surface has to be configured again before it can be mapped, buffers are kept as they are
+	surface->hidden = true;
+	surface->configured = false;
+	surface->committed = false;
+	surface->dirty = false;
+	surface->render_pending = false;
+}
+
+void
+wob_surface_show(struct wob_surface *surface)
+{
+	surface->hidden = false;
+	surface->dirty = true;
+
+	if (surface->configured) {
+		wob_surface_render(surface);
+		return;
+	}
 
-	wl_surface_attach(surface->wl_surface, surface->wob_buffer->wl_buffer, 0, 0);
-	wl_surface_damage_buffer(surface->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+	// commit without a buffer requests a new configure event, which renders the bar
 	wl_surface_commit(surface->wl_surface);
 }
 
 void
 wob_surface_destroy(struct wob_surface *wob_surface)
 {
+	if (wob_surface->frame_callback != NULL) {
+		wl_callback_destroy(wob_surface->frame_callback);
+	}
+	// feedback still pending is never going to be delivered
+	struct wob_frame *frame, *frame_tmp;
+	wl_list_for_each_safe (frame, frame_tmp, &wob_surface->frames, link) {
+		wp_presentation_feedback_destroy(frame->feedback);
+		wl_list_remove(&frame->link);
+		free(frame);
+	}
+	if (wob_surface->bar_wl_surface != NULL) {
+		wp_viewport_destroy(wob_surface->bar_viewport);
+		wl_subsurface_destroy(wob_surface->bar_subsurface);
+		wl_surface_destroy(wob_surface->bar_wl_surface);
+	}
+	if (wob_surface->bar_buffer_pool != NULL) {
+		wob_buffer_pool_unref(wob_surface->bar_buffer_pool);
+	}
+	for (size_t i = 0; i < WOB_IMAGE_PARTS_COUNT; ++i) {
+		struct wob_solid_part *part = &wob_surface->solid_parts[i];
+		if (part->wl_surface != NULL) {
+			wp_viewport_destroy(part->wp_viewport);
+			wl_subsurface_destroy(part->wl_subsurface);
+			wl_surface_destroy(part->wl_surface);
+		}
+	}
+	for (size_t i = 0; i < 3; ++i) {
+		if (wob_surface->solid_buffers[i] != NULL) {
+			wl_buffer_destroy(wob_surface->solid_buffers[i]);
+		}
+	}
+	if (wob_surface->solid_transparent_buffer != NULL) {
+		wl_buffer_destroy(wob_surface->solid_transparent_buffer);
+	}
 	zwlr_layer_surface_v1_destroy(wob_surface->wlr_layer_surface);
 	wl_surface_destroy(wob_surface->wl_surface);
 
@@ -351,10 +1250,11 @@ wob_surface_destroy(struct wob_surface *wob_surface)
 	if (wob_surface->fractional != NULL) {
 		wp_fractional_scale_v1_destroy(wob_surface->fractional);
 	}
-	if (wob_surface->wob_buffer != NULL) {
-		wob_buffer_destroy(wob_surface->wob_buffer);
+	if (wob_surface->buffer_pool != NULL) {
+		wob_buffer_pool_unref(wob_surface->buffer_pool);
 	}
 
+	wl_list_remove(&wob_surface->link);
 	free(wob_surface);
 }
 
@@ -382,6 +1282,7 @@ xdg_output_handle_name(void *data, struct wl_output *wl_output, const char *name
 	if (output->name == NULL) {
 		wob_log_panic("strdup failed");
 	}
+	output->config_resolved = false;
 }
 
 void
@@ -397,6 +1298,7 @@ xdg_output_handle_description(void *data, struct wl_output *wl_output, const cha
 	if (output->description == NULL) {
 		wob_log_panic("strdup failed");
 	}
+	output->config_resolved = false;
 }
 
 void
@@ -424,6 +1326,7 @@ xdg_output_handle_geometry(
 		}
 
 		snprintf(output->description, size, "%s %s", make, model);
+		output->config_resolved = false;
 	}
 }
 
@@ -433,10 +1336,24 @@ xdg_output_handle_done(void *data, struct wl_output *wl_output)
 	(void) wl_output;
 
 	struct wob_output *output = data;
+	output->done = true;
 
 	wob_log_debug("Detected new output name = %s, description = %s", output->name, output->description);
 }
 
+void
+wl_shm_handle_format(void *data, struct wl_shm *wl_shm, uint32_t format)
+{
+	(void) data;
+	(void) wl_shm;
+
+	for (enum wob_pixel_format pixel_format = 0; pixel_format < WOB_PIXEL_FORMATS_COUNT; ++pixel_format) {
+		if (wob_pixel_format_to_wl_shm(pixel_format) == format) {
+			managers.shm_formats |= 1u << pixel_format;
+		}
+	}
+}
+
 void
 handle_global(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
 {
@@ -452,7 +1369,12 @@ handle_global(void *data, struct wl_registry *registry, uint32_t name, const cha
 	struct wob *app = data;
 
 	if (strcmp(interface, wl_shm_interface.name) == 0) {
+		static const struct wl_shm_listener wl_shm_listener = {
+			.format = wl_shm_handle_format,
+		};
+
 		managers.wl_shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+		wl_shm_add_listener(managers.wl_shm, &wl_shm_listener, NULL);
 	}
 	else if (strcmp(interface, wl_compositor_interface.name) == 0) {
 		managers.wl_compositor = wl_registry_bind(registry, name, &wl_compositor_interface, 4);
@@ -477,12 +1399,26 @@ handle_global(void *data, struct wl_registry *registry, uint32_t name, const cha
 	else if (strcmp(interface, zwlr_layer_shell_v1_interface.name) == 0) {
 		managers.wlr_layer_shell = wl_registry_bind(registry, name, &zwlr_layer_shell_v1_interface, 1);
 	}
+	else if (strcmp(interface, wl_subcompositor_interface.name) == 0) {
+		managers.wl_subcompositor = wl_registry_bind(registry, name, &wl_subcompositor_interface, 1);
+	}
 	else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
 		managers.wp_viewporter = wl_registry_bind(registry, name, &wp_viewporter_interface, 1);
 	}
 	else if (strcmp(interface, wp_fractional_scale_manager_v1_interface.name) == 0) {
 		managers.wp_fractional_scale = wl_registry_bind(registry, name, &wp_fractional_scale_manager_v1_interface, 1);
 	}
+	else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+		static const struct wp_presentation_listener wp_presentation_listener = {
+			.clock_id = wp_presentation_handle_clock_id,
+		};
+
+		managers.wp_presentation = wl_registry_bind(registry, name, &wp_presentation_interface, 1);
+		wp_presentation_add_listener(managers.wp_presentation, &wp_presentation_listener, NULL);
+	}
+	else if (strcmp(interface, wp_single_pixel_buffer_manager_v1_interface.name) == 0) {
+		managers.wp_single_pixel_buffer = wl_registry_bind(registry, name, &wp_single_pixel_buffer_manager_v1_interface, 1);
+	}
 }
 
 void
@@ -496,6 +1432,12 @@ handle_global_remove(void *data, struct wl_registry *registry, uint32_t name)
 	wl_list_for_each_safe (output, output_tmp, &(app->wob_outputs), link) {
 		if (output->wl_name == name) {
 			wob_log_info("Output %s disconnected", output->name);
+			struct wob_surface *surface, *surface_tmp;
+			wl_list_for_each_safe (surface, surface_tmp, &app->surfaces, link) {
+				if (surface->output == output) {
+					wob_surface_destroy(surface);
+				}
+			}
 			wl_list_remove(&output->link);
 			wob_output_destroy(output);
 			return;
@@ -503,19 +1445,336 @@ handle_global_remove(void *data, struct wl_registry *registry, uint32_t name)
 	}
 }
 
+bool
+wob_visible(struct wob *app)
+{
+	struct wob_surface *surface;
+	wl_list_for_each (surface, &app->surfaces, link) {
+		if (!surface->hidden) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+wob_sync_surfaces(struct wob *app)
+{
+	if (app->config->output_mode == WOB_OUTPUT_MODE_FOCUSED) {
+		if (wl_list_empty(&app->surfaces)) {
+			wob_create_surface(app, NULL);
+		}
+		return;
+	}
+
+	// outputs connected since the last input get their surface now, surfaces of disconnected ones are already gone
+	struct wob_output *output;
+	wl_list_for_each (output, &app->wob_outputs, link) {
+		if (!output->done) {
+			continue;
+		}
+
+		bool has_surface = false;
+		struct wob_surface *surface;
+		wl_list_for_each (surface, &app->surfaces, link) {
+			if (surface->output == output) {
+				has_surface = true;
+				break;
+			}
+		}
+		if (has_surface) {
+			continue;
+		}
+
+		if (app->config->output_mode == WOB_OUTPUT_MODE_WHITELIST && wob_output_resolve_config(app, output) == NULL) {
+			continue;
+		}
+
+		wob_log_info("Creating surface on output %s", output->name);
+		wob_create_surface(app, output);
+	}
+}
+
+bool
+wob_parse_input(struct wob_config *config, char *line, unsigned long *value, struct wob_style **style)
+{
+	while (*line == ' ') {
+		line += 1;
+	}
+
+	// line is tokenized in place, style name is everything after the first space
+	char *style_name = strchr(line, ' ');
+	if (style_name != NULL) {
+		*style_name = '\0';
+		style_name += 1;
+		if (*style_name == '\0') {
+			style_name = NULL;
+		}
+	}
+
+	enum wob_input_operation operation;
+	unsigned long amount;
+	if (!wob_input_parse_value(line, &operation, &amount)) {
+		wob_log_warn("Invalid value received '%s'", line);
+		return false;
+	}
+
+	struct wob_style *selected_style = &config->default_style;
+	wob_log_info_value(line, "Received input { value = %s, style = %s }", line, style_name != NULL ? style_name : "<empty>");
+	if (style_name != NULL) {
+		struct wob_style *selected_style_search = wob_config_find_style(config, style_name);
+		if (selected_style_search != NULL) {
+			selected_style = selected_style_search;
+		}
+		else {
+			wob_log_warn("Style named '%s' not found, using the default one", style_name);
+		}
+	}
+
+	// every style is its own channel, relative steps are kept within max by overflow_mode
+	bool wrap = config->overflow_mode == WOB_OVERFLOW_MODE_WRAP;
+	selected_style->value = wob_input_apply_value(selected_style->value, operation, amount, config->max, wrap);
+
+	*value = selected_style->value;
+	*style = selected_style;
+
+	return true;
+}
+
+void
+wob_show_value(struct wob *state, unsigned long percentage, struct wob_style *selected_style, struct timespec input_time)
+{
+	struct wob_colors effective_colors;
+	if (percentage > state->config->max) {
+		effective_colors = selected_style->overflow_colors;
+		switch (state->config->overflow_mode) {
+			case WOB_OVERFLOW_MODE_WRAP:
+				percentage %= state->config->max;
+				break;
+			case WOB_OVERFLOW_MODE_NOWRAP:
+				percentage = state->config->max;
+				break;
+		}
+	}
+	else {
+		effective_colors = selected_style->colors;
+	}
+
+	if (wl_list_empty(&state->wob_outputs)) {
+		wob_log_info("No output found to render wob on");
+		return;
+	}
+
+	wob_log_info(
+		"Rendering { value = %lu, bg = %08lX, border = %08lX, bar = %08lX }",
+		percentage,
+		(unsigned long) effective_colors.packed[WOB_PIXEL_FORMAT_ARGB8888].background,
+		(unsigned long) effective_colors.packed[WOB_PIXEL_FORMAT_ARGB8888].border,
+		(unsigned long) effective_colors.packed[WOB_PIXEL_FORMAT_ARGB8888].value
+	);
+
+	wob_sync_surfaces(state);
+	if (wl_list_empty(&state->surfaces)) {
+		wob_log_info("No output matches output_mode to render wob on");
+		return;
+	}
+
+	bool coalesced = false;
+	double desired_percentage = (double) percentage / (double) state->config->max;
+	struct wob_surface *surface;
+	wl_list_for_each (surface, &state->surfaces, link) {
+		// only a bar already on screen in the same colors is animated, everything else jumps straight to the value
+		bool animate = state->config->animation_duration_msec > 0 && !surface->hidden && surface->committed && wob_colors_eq(surface->committed_colors, effective_colors);
+		if (animate) {
+			wob_animation_start(&surface->animation, surface->desired_percentage, desired_percentage);
+		}
+		else {
+			surface->animation = (struct wob_animation) {0};
+			surface->desired_percentage = desired_percentage;
+		}
+		surface->animation_frame = false;
+
+		surface->desired_colors = effective_colors;
+		surface->desired_input_time = input_time;
+		if (surface->hidden) {
+			surface->show_pending = true;
+			surface->show_requested = input_time;
+			wob_surface_show(surface);
+		}
+		else if (wob_surface_schedule_frame(surface)) {
+			coalesced = true;
+		}
+	}
+
+	// deadline counts from the last shown value, wayland traffic in between doesn't move it
+	struct itimerspec deadline = {
+		.it_value = {.tv_sec = state->config->timeout_msec / 1000, .tv_nsec = (state->config->timeout_msec % 1000) * 1000000},
+	};
+	if (timerfd_settime(state->hide_timer_fd, 0, &deadline, NULL) == -1) {
+		wob_log_panic("timerfd_settime() failed: %s", strerror(errno));
+	}
+
+	// counted once, no matter how many outputs skipped the superseded value
+	if (coalesced) {
+		state->coalesced_inputs += 1;
+		wob_log_debug("coalesced input, %lu of %lu inputs coalesced so far", state->coalesced_inputs, state->inputs);
+	}
+}
+
+void
+wob_handle_input(struct wob *state, struct wob_input *input, struct timespec input_time, bool eof)
+{
+	// only the newest valid value gets rendered, older ones from the same burst are coalesced right away
+	unsigned long percentage = 0;
+	struct wob_style *selected_style = NULL;
+	unsigned long valid_inputs = 0;
+	char *line;
+	while ((line = wob_input_next_line(input)) != NULL) {
+		if (wob_parse_input(state->config, line, &percentage, &selected_style)) {
+			valid_inputs += 1;
+		}
+	}
+
+	// client that disconnected without a trailing newline still gets its last value shown
+	if (eof && (line = wob_input_last_line(input)) != NULL && wob_parse_input(state->config, line, &percentage, &selected_style)) {
+		valid_inputs += 1;
+	}
+
+	if (valid_inputs == 0) {
+		return;
+	}
+	state->inputs += valid_inputs;
+	state->coalesced_inputs += valid_inputs - 1;
+
+	wob_show_value(state, percentage, selected_style, input_time);
+}
+
+void
+wob_handle_sources(struct wob *state, struct timespec input_time)
+{
+	wob_source_watch_dispatch(state->source_watch_fd, state->sources, state->sources_count);
+
+	for (size_t i = 0; i < state->sources_count; ++i) {
+		struct wob_source *source = &state->sources[i];
+		if (!source->dirty || !wob_source_read(source)) {
+			continue;
+		}
+
+		// scaled to max, so relative inputs of the same style continue from here
+		unsigned long value = (unsigned long) ((double) source->value * state->config->max / source->max + 0.5);
+		wob_log_info("Source %s changed { value = %lu, max = %lu }", source->config->id, source->value, source->max);
+		source->config->style->value = value;
+		state->inputs += 1;
+
+		wob_show_value(state, value, source->config->style, input_time);
+	}
+}
+
+void
+wob_epoll_ctl(int epoll_fd, int op, int fd, uint32_t events)
+{
+	struct epoll_event event = {.events = events, .data.fd = fd};
+	if (epoll_ctl(epoll_fd, op, fd, &event) == -1) {
+		wob_log_panic("epoll_ctl(%d, %d) failed: %s", op, fd, strerror(errno));
+	}
+}
+
+enum wob_pixel_format
+wob_select_pixel_format(struct wob_config *config)
+{
+	if (config->buffer_format == WOB_BUFFER_FORMAT_RGB565) {
+		if (managers.shm_formats & (1u << WOB_PIXEL_FORMAT_RGB565)) {
+			return WOB_PIXEL_FORMAT_RGB565;
+		}
+		wob_log_warn("Compositor doesn't support rgb565 buffers, falling back to a 32-bit format");
+	}
+
+	// every compositor supports both, without alpha the compositor can skip blending
+	return config->opaque ? WOB_PIXEL_FORMAT_XRGB8888 : WOB_PIXEL_FORMAT_ARGB8888;
+}
+
 int
-wob_run(struct wob_config *config)
+wob_run(struct wob_config *config, int listen_fd)
 {
 	int _exit_code;
 
 	wl_surface_frame_listener.done = &wl_surface_frame_done;
+	managers.presentation_clock = CLOCK_MONOTONIC;
+
+	// signals are read from the loop, SIGUSR1 dumps latency histograms and the others exit cleanly
+	// all of it has to be set up before wob_pledge()
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	if (sigprocmask(SIG_BLOCK, &signals, NULL) != 0) {
+		wob_log_panic("sigprocmask() failed: %s", strerror(errno));
+	}
+	int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (signal_fd == -1) {
+		wob_log_panic("signalfd() failed: %s", strerror(errno));
+	}
+
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd == -1) {
+		wob_log_panic("epoll_create1() failed: %s", strerror(errno));
+	}
 
 	struct wob *state = calloc(1, sizeof(struct wob));
 
-	state->shmid = wob_shm_open();
+	state->hide_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (state->hide_timer_fd == -1) {
+		wob_log_panic("timerfd_create() failed: %s", strerror(errno));
+	}
+
+	// shm has to be opened before wob_pledge()
+	if (!wob_shm_open(&state->shm_pool.shm)) {
+		wob_log_panic("wob_shm_open() failed");
+	}
+	state->bar_shm_pool.shm.fd = -1;
+	if (config->render_mode == WOB_RENDER_MODE_SUBSURFACE && !wob_shm_open(&state->bar_shm_pool.shm)) {
+		wob_log_panic("wob_shm_open() failed");
+	}
 
 	state->config = config;
 	wl_list_init(&state->wob_outputs);
+	wl_list_init(&state->surfaces);
+	wl_list_init(&state->shm_pool.buffer_pools);
+	wl_list_init(&state->bar_shm_pool.buffer_pools);
+	wob_image_cache_init(&state->image_cache);
+	wob_input_init(&state->input, STDIN_FILENO);
+
+	bool listening = listen_fd != -1;
+	struct wob_server server;
+	if (listening) {
+		wob_server_init(&server, listen_fd);
+	}
+
+	// source files have to be opened before wob_pledge()
+	state->source_watch_fd = -1;
+	state->sources_count = wl_list_length(&config->sources);
+	if (state->sources_count > 0) {
+		state->sources = calloc(state->sources_count, sizeof(struct wob_source));
+		if (state->sources == NULL) {
+			wob_log_panic("calloc() failed");
+		}
+
+		state->source_watch_fd = wob_source_watch_create();
+		if (state->source_watch_fd == -1) {
+			wob_log_panic("Failed to watch value sources");
+		}
+
+		size_t i = 0;
+		struct wob_source_config *source_config;
+		wl_list_for_each (source_config, &config->sources, link) {
+			if (!wob_source_open(&state->sources[i], source_config, state->source_watch_fd, config->max)) {
+				wob_log_panic("Failed to open source %s", source_config->id);
+			}
+			i += 1;
+		}
+	}
 
 	static const struct wl_registry_listener wl_registry_listener = {
 		.global = handle_global,
@@ -550,152 +1809,260 @@ wob_run(struct wob_config *config)
 		wob_log_panic("Wayland compositor doesn't support all required protocols");
 	}
 
-	struct wob_colors effective_colors;
+	state->render_mode = config->render_mode;
+	if (state->render_mode == WOB_RENDER_MODE_SUBSURFACE && (managers.wl_subcompositor == NULL || managers.wp_viewporter == NULL)) {
+		wob_log_warn("Compositor doesn't support %s and %s, falling back to buffer render mode", wl_subcompositor_interface.name, wp_viewporter_interface.name);
+		state->render_mode = WOB_RENDER_MODE_BUFFER;
+	}
+	if (state->render_mode == WOB_RENDER_MODE_SOLID && (managers.wp_single_pixel_buffer == NULL || managers.wl_subcompositor == NULL || managers.wp_viewporter == NULL)) {
+		wob_log_warn(
+			"Compositor doesn't support %s, %s and %s, falling back to buffer render mode",
+			wp_single_pixel_buffer_manager_v1_interface.name,
+			wl_subcompositor_interface.name,
+			wp_viewporter_interface.name
+		);
+		state->render_mode = WOB_RENDER_MODE_BUFFER;
+	}
 
-	struct pollfd fds[2] = {
-		{
-			.fd = wl_display_get_fd(wl_display),
-			.events = POLLIN,
-		},
-		{
-			.fd = STDIN_FILENO,
-			.events = POLLIN,
-		},
-	};
+	state->pixel_format = wob_select_pixel_format(config);
+	wob_log_info("Drawing %s buffers", wob_pixel_format_name(state->pixel_format));
+
+	// every fd is registered once, clients are added and removed as they connect and disconnect
+	int wl_display_fd = wl_display_get_fd(wl_display);
+	int input_fd = listening ? server.listen_fd : state->input.fd;
+	wob_epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wl_display_fd, EPOLLIN);
+	// epoll refuses regular files and /dev/null, stdin redirected from them is always readable and never waited for
+	bool input_always_readable = false;
+	struct epoll_event input_event = {.events = EPOLLIN, .data.fd = input_fd};
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, input_fd, &input_event) == -1) {
+		if (listening || errno != EPERM) {
+			wob_log_panic("epoll_ctl(%d, %d) failed: %s", EPOLL_CTL_ADD, input_fd, strerror(errno));
+		}
+		input_always_readable = true;
+	}
+	wob_epoll_ctl(epoll_fd, EPOLL_CTL_ADD, state->hide_timer_fd, EPOLLIN);
+	wob_epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, EPOLLIN);
+	if (state->source_watch_fd != -1) {
+		wob_epoll_ctl(epoll_fd, EPOLL_CTL_ADD, state->source_watch_fd, EPOLLIN);
+	}
 
+	// one spare slot for the event of an always readable stdin
+	struct epoll_event events[WOB_EPOLL_EVENTS + 1];
 	for (;;) {
-		char input_buffer[INPUT_BUFFER_LENGTH] = {0};
-
-		int timeout = -1;
-		if (state->surface != NULL) {
-			timeout = state->config->timeout_msec;
+		// events already queued by libwayland have to be dispatched first, the fd won't wake us up for them
+		while (wl_display_prepare_read(wl_display) != 0) {
+			if (wl_display_dispatch_pending(wl_display) == -1) {
+				wob_log_panic("wl_display_dispatch_pending failed");
+			}
+		}
+		wl_display_flush(wl_display);
+		// everything logged during the last iteration goes out in one write
+		wob_log_flush();
+
+		int events_count = epoll_wait(epoll_fd, events, WOB_EPOLL_EVENTS, input_always_readable ? 0 : -1);
+		if (events_count == -1) {
+			wl_display_cancel_read(wl_display);
+			if (errno == EINTR) {
+				continue;
+			}
+			wob_log_panic("epoll_wait() failed: %s", strerror(errno));
+		}
+		if (input_always_readable) {
+			events[events_count] = input_event;
+			events_count += 1;
 		}
 
-		switch (poll(fds, 2, timeout)) {
-			case -1:
-				wob_log_panic("poll() failed: %s", strerror(errno));
-			case 0:
-				if (state->surface != NULL) {
-					wob_log_info("Hiding bar");
-					wob_surface_destroy(state->surface);
-					state->surface = NULL;
+		// wayland goes first, the other handlers send requests and must not do so while a read is prepared
+		bool wayland_readable = false;
+		for (int i = 0; i < events_count; ++i) {
+			if (events[i].data.fd != wl_display_fd) {
+				continue;
+			}
+
+			if (!(events[i].events & EPOLLIN)) {
+				wl_display_cancel_read(wl_display);
+				wob_log_panic("WL_DISPLAY_FD unexpectedly closed, events = %u", events[i].events);
+			}
+			wayland_readable = true;
+		}
 
-					wl_display_flush(wl_display);
+		if (wayland_readable) {
+			wob_log_debug("read");
+			if (wl_display_read_events(wl_display) == -1 || wl_display_dispatch_pending(wl_display) == -1) {
+				wob_log_panic("wl_display_read_events failed");
+			}
+
+			// wl_buffer.release might have freed a buffer for the postponed frame
+			struct wob_surface *surface;
+			wl_list_for_each (surface, &state->surfaces, link) {
+				if (surface->render_pending) {
+					wob_surface_render(surface);
 				}
+			}
+		}
+		else {
+			wl_display_cancel_read(wl_display);
+		}
 
-				break;
-			default:
-				if (fds[0].revents) {
-					if (!(fds[0].revents & POLLIN)) {
-						wob_log_panic("WL_DISPLAY_FD unexpectedly closed, revents = %hd", fds[0].revents);
-					}
+		for (int i = 0; i < events_count; ++i) {
+			int fd = events[i].data.fd;
+			uint32_t revents = events[i].events;
+
+			if (fd == wl_display_fd) {
+				continue;
+			}
+			else if (fd == state->hide_timer_fd) {
+				uint64_t expirations;
+				if (read(state->hide_timer_fd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN) {
+					wob_log_panic("read() from timerfd failed: %s", strerror(errno));
+				}
 
-					wob_log_debug("read");
-					if (wl_display_dispatch(wl_display) == -1) {
-						wob_log_panic("wl_display_dispatch failed");
+				if (wob_visible(state)) {
+					wob_log_info("Hiding bar, %lu of %lu inputs coalesced so far", state->coalesced_inputs, state->inputs);
+					wob_latency_log(&state->latency, WOB_LOG_INFO);
+					struct wob_surface *surface, *surface_tmp;
+					wl_list_for_each_safe (surface, surface_tmp, &state->surfaces, link) {
+						switch (state->config->hide_mode) {
+							case WOB_HIDE_MODE_DESTROY:
+								wob_surface_destroy(surface);
+								break;
+							case WOB_HIDE_MODE_UNMAP:
+								wob_surface_hide(surface);
+								break;
+						}
 					}
-
-					wl_display_flush(wl_display);
 				}
-
-				if (fds[1].revents) {
-					if (!(fds[1].revents & POLLIN)) {
-						wob_log_error("STDIN unexpectedly closed, revents = %hd", fds[1].revents);
-						_exit_code = EXIT_FAILURE;
-						goto _exit_cleanup;
+			}
+			else if (fd == signal_fd) {
+				struct signalfd_siginfo siginfo;
+				while (read(signal_fd, &siginfo, sizeof(siginfo)) == sizeof(siginfo)) {
+					if (siginfo.ssi_signo == SIGUSR1) {
+						wob_latency_log(&state->latency, WOB_LOG_WARN);
+						continue;
 					}
 
-					char *fgets_rv = fgets(input_buffer, INPUT_BUFFER_LENGTH, stdin);
-					if (fgets_rv == NULL) {
-						if (feof(stdin)) {
-							wob_log_info("Received EOF");
-							_exit_code = EXIT_SUCCESS;
-						}
-						else {
-							wob_log_error("fgets() failed: %s", strerror(errno));
-							_exit_code = EXIT_FAILURE;
-						}
-						goto _exit_cleanup;
-					}
+					wob_log_info("Received signal %u, exiting", siginfo.ssi_signo);
+					_exit_code = EXIT_SUCCESS;
+					goto _exit_cleanup;
+				}
+			}
+			else if (fd == state->source_watch_fd) {
+				struct timespec input_time;
+				clock_gettime(managers.presentation_clock, &input_time);
+
+				wob_handle_sources(state, input_time);
+			}
+			else if (listening && fd == server.listen_fd) {
+				if (revents & EPOLLERR) {
+					wob_log_error("Listening socket unexpectedly closed, events = %u", revents);
+					_exit_code = EXIT_FAILURE;
+					goto _exit_cleanup;
+				}
 
-					// strip newline from the end of the buffer
-					strtok(input_buffer, "\n");
+				struct wob_input *client = wob_server_accept(&server);
+				if (client != NULL) {
+					wob_epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client->fd, EPOLLIN);
+				}
+				// pending connections wait in the backlog while the client table is full
+				if (server.clients_count == WOB_SERVER_MAX_CLIENTS) {
+					wob_epoll_ctl(epoll_fd, EPOLL_CTL_MOD, server.listen_fd, 0);
+				}
+			}
+			else if (!listening && fd == state->input.fd) {
+				// hangup without data is the writer going away, read() reports it as EOF
+				if (!(revents & (EPOLLIN | EPOLLHUP))) {
+					wob_log_error("STDIN unexpectedly closed, events = %u", revents);
+					_exit_code = EXIT_FAILURE;
+					goto _exit_cleanup;
+				}
 
-					char *str_end;
-					char *token = strtok(input_buffer, " ");
-					unsigned long percentage = strtoul(token, &str_end, 10);
-					if (*str_end != '\0') {
-						wob_log_warn("Invalid value received '%s'", token);
-						break;
-					}
+				struct timespec input_time;
+				clock_gettime(managers.presentation_clock, &input_time);
 
-					struct wob_style *selected_style = &state->config->default_style;
-					token = strtok(NULL, "");
-					wob_log_info("Received input { value = %lu, style = %s }", percentage, token != NULL ? token : "<empty>");
-					if (token != NULL) {
-						struct wob_style *selected_style_search = wob_config_find_style(state->config, token);
-						if (selected_style_search != NULL) {
-							selected_style = selected_style_search;
-						}
-						else {
-							wob_log_warn("Style named '%s' not found, using the default one", token);
-						}
-					}
+				ssize_t bytes_read = wob_input_read(&state->input);
+				if (bytes_read == 0) {
+					// last line may lack its newline, printf 50 | wob
+					wob_handle_input(state, &state->input, input_time, true);
+					wob_log_info("Received EOF");
+					_exit_code = EXIT_SUCCESS;
+					goto _exit_cleanup;
+				}
+				if (bytes_read == -1) {
+					wob_log_error("read() failed: %s", strerror(errno));
+					_exit_code = EXIT_FAILURE;
+					goto _exit_cleanup;
+				}
 
-					if (percentage > state->config->max) {
-						effective_colors = selected_style->overflow_colors;
-						switch (state->config->overflow_mode) {
-							case WOB_OVERFLOW_MODE_WRAP:
-								percentage %= state->config->max;
-								break;
-							case WOB_OVERFLOW_MODE_NOWRAP:
-								percentage = state->config->max;
-								break;
-						}
-					}
-					else {
-						effective_colors = selected_style->colors;
-					}
+				wob_handle_input(state, &state->input, input_time, false);
+			}
+			else if (listening) {
+				size_t index = 0;
+				while (index < server.clients_count && server.clients[index]->fd != fd) {
+					index += 1;
+				}
+				if (index == server.clients_count) {
+					continue;
+				}
 
-					if (wl_list_empty(&state->wob_outputs)) {
-						wob_log_info("No output found to render wob on");
-						break;
-					}
+				struct wob_input *client = server.clients[index];
+				struct timespec input_time;
+				clock_gettime(managers.presentation_clock, &input_time);
 
-					wob_log_info(
-						"Rendering { value = %lu, bg = " WOB_COLOR_PRINTF_FORMAT ", border = " WOB_COLOR_PRINTF_FORMAT ", bar = " WOB_COLOR_PRINTF_FORMAT " }",
-						percentage,
-						WOB_COLOR_PRINTF_RGBA(effective_colors.background),
-						WOB_COLOR_PRINTF_RGBA(effective_colors.border),
-						WOB_COLOR_PRINTF_RGBA(effective_colors.value)
-					);
+				ssize_t bytes_read = wob_input_read(client);
+				if (bytes_read == -1) {
+					wob_log_warn("read() from client %d failed: %s", client->fd, strerror(errno));
+				}
+				else {
+					wob_handle_input(state, client, input_time, bytes_read == 0);
+				}
 
-					if (state->surface == NULL) {
-						state->surface = wob_create_surface(state);
-					}
-					else {
-						struct wl_callback *cb = wl_surface_frame(state->surface->wl_surface);
-						wl_callback_add_listener(cb, &wl_surface_frame_listener, state->surface);
-						wl_surface_commit(state->surface->wl_surface);
+				if (bytes_read <= 0) {
+					wob_epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, 0);
+					wob_server_close_client(&server, index);
+					if (server.clients_count == WOB_SERVER_MAX_CLIENTS - 1) {
+						wob_epoll_ctl(epoll_fd, EPOLL_CTL_MOD, server.listen_fd, EPOLLIN);
 					}
-
-					state->surface->desired_colors = effective_colors;
-					state->surface->desired_percentage = (double) percentage / (double) state->config->max;
-
-					wl_display_flush(wl_display);
 				}
+			}
 		}
 	}
 
 _exit_cleanup:
 	// cleanup state
-	if (state->surface != NULL) {
-		wob_surface_destroy(state->surface);
+	if (listening) {
+		wob_server_destroy(&server);
+	}
+	for (size_t i = 0; i < state->sources_count; ++i) {
+		wob_source_close(&state->sources[i]);
+	}
+	free(state->sources);
+	if (state->source_watch_fd != -1) {
+		close(state->source_watch_fd);
+	}
+	close(state->hide_timer_fd);
+	close(signal_fd);
+	close(epoll_fd);
+	struct wob_surface *surface, *surface_tmp;
+	wl_list_for_each_safe (surface, surface_tmp, &state->surfaces, link) {
+		wob_surface_destroy(surface);
 	}
 	struct wob_output *output, *output_tmp;
 	wl_list_for_each_safe (output, output_tmp, &state->wob_outputs, link) {
 		wob_output_destroy(output);
 	}
+	wob_image_cache_destroy(&state->image_cache);
+	struct wob_shm_pool *shm_pools[] = {&state->shm_pool, &state->bar_shm_pool};
+	for (size_t i = 0; i < sizeof(shm_pools) / sizeof(shm_pools[0]); ++i) {
+		// pools whose buffers the compositor never got to release
+		struct wob_buffer_pool *pool, *pool_tmp;
+		wl_list_for_each_safe (pool, pool_tmp, &shm_pools[i]->buffer_pools, link) {
+			wob_buffer_pool_destroy(pool);
+		}
+		if (shm_pools[i]->wl_shm_pool != NULL) {
+			wl_shm_pool_destroy(shm_pools[i]->wl_shm_pool);
+		}
+		wob_shm_close(&shm_pools[i]->shm);
+	}
 	wob_config_destroy(state->config);
 	free(state);
 
@@ -706,6 +2073,15 @@ _exit_cleanup:
 	if (managers.wp_viewporter != NULL) {
 		wp_viewporter_destroy(managers.wp_viewporter);
 	}
+	if (managers.wl_subcompositor != NULL) {
+		wl_subcompositor_destroy(managers.wl_subcompositor);
+	}
+	if (managers.wp_single_pixel_buffer != NULL) {
+		wp_single_pixel_buffer_manager_v1_destroy(managers.wp_single_pixel_buffer);
+	}
+	if (managers.wp_presentation != NULL) {
+		wp_presentation_destroy(managers.wp_presentation);
+	}
 	if (managers.wp_fractional_scale != NULL) {
 		wp_fractional_scale_manager_v1_destroy(managers.wp_fractional_scale);
 	}
@@ -3,8 +3,6 @@
 
 #include "config.h"
 
-#define INPUT_BUFFER_LENGTH 255
-
-int wob_run(struct wob_config *config);
+int wob_run(struct wob_config *config, int listen_fd);
 
 #endif
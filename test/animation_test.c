@@ -0,0 +1,122 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include "src/animation.h"
+
+static const enum wob_animation_curve curves[] = {
+	WOB_ANIMATION_CURVE_LINEAR,
+	WOB_ANIMATION_CURVE_EASE_IN,
+	WOB_ANIMATION_CURVE_EASE_OUT,
+	WOB_ANIMATION_CURVE_EASE_IN_OUT,
+};
+
+bool
+close_to(double a, double b)
+{
+	return a - b < 1e-9 && b - a < 1e-9;
+}
+
+void
+test_curves_are_monotonic(void **state)
+{
+	(void) state;
+
+	for (size_t i = 0; i < sizeof(curves) / sizeof(curves[0]); ++i) {
+		assert_true(wob_animation_ease(curves[i], 0.0) == 0.0);
+		assert_true(wob_animation_ease(curves[i], 1.0) == 1.0);
+		assert_true(wob_animation_ease(curves[i], -1.0) == 0.0);
+		assert_true(wob_animation_ease(curves[i], 2.0) == 1.0);
+
+		double previous = 0.0;
+		for (int step = 1; step <= 100; ++step) {
+			double eased = wob_animation_ease(curves[i], step / 100.0);
+			assert_true(eased >= previous);
+			previous = eased;
+		}
+	}
+
+	assert_true(close_to(wob_animation_ease(WOB_ANIMATION_CURVE_EASE_IN_OUT, 0.5), 0.5));
+	assert_true(wob_animation_ease(WOB_ANIMATION_CURVE_EASE_OUT, 0.25) > 0.25);
+	assert_true(wob_animation_ease(WOB_ANIMATION_CURVE_EASE_IN, 0.25) < 0.25);
+}
+
+void
+test_animation_settles_at_target(void **state)
+{
+	(void) state;
+
+	struct wob_animation animation = {0};
+	wob_animation_start(&animation, 0.2, 0.6);
+	assert_true(animation.running);
+
+	// first frame already shows a step, as if the animation started a frame earlier
+	double first = 0.2 + 0.4 * WOB_ANIMATION_FIRST_STEP_MSEC / 100.0;
+	assert_true(close_to(wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 5000), first));
+	assert_true(animation.started);
+	assert_true(close_to(wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 5050 - WOB_ANIMATION_FIRST_STEP_MSEC), 0.4));
+	assert_true(animation.running);
+
+	// late frame jumps right to the target and stops the animation
+	assert_true(wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 5200) == 0.6);
+	assert_false(animation.running);
+	assert_false(animation.started);
+	assert_true(wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 5300) == 0.6);
+}
+
+void
+test_animation_survives_time_wrapping(void **state)
+{
+	(void) state;
+
+	struct wob_animation animation = {0};
+	wob_animation_start(&animation, 1.0, 0.0);
+	wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, UINT32_MAX - 24 + WOB_ANIMATION_FIRST_STEP_MSEC);
+	assert_true(close_to(wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 25), 0.5));
+	assert_true(animation.running);
+}
+
+void
+test_animation_to_same_value_does_not_run(void **state)
+{
+	(void) state;
+
+	struct wob_animation animation = {0};
+	wob_animation_start(&animation, 0.5, 0.5);
+	assert_false(animation.running);
+	assert_true(wob_animation_step(&animation, WOB_ANIMATION_CURVE_EASE_OUT, 100, 0) == 0.5);
+}
+
+void
+test_retarget_starts_from_current_value(void **state)
+{
+	(void) state;
+
+	struct wob_animation animation = {0};
+	wob_animation_start(&animation, 0.0, 1.0);
+	wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 0);
+	double current = wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 30);
+
+	wob_animation_start(&animation, current, 0.0);
+	assert_false(animation.started);
+	assert_true(close_to(wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 46), current * (1.0 - WOB_ANIMATION_FIRST_STEP_MSEC / 100.0)));
+	assert_true(close_to(wob_animation_step(&animation, WOB_ANIMATION_CURVE_LINEAR, 100, 96 - WOB_ANIMATION_FIRST_STEP_MSEC), current / 2));
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_curves_are_monotonic),
+		cmocka_unit_test(test_animation_settles_at_target),
+		cmocka_unit_test(test_animation_survives_time_wrapping),
+		cmocka_unit_test(test_animation_to_same_value_does_not_run),
+		cmocka_unit_test(test_retarget_starts_from_current_value),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
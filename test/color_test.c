@@ -85,6 +85,26 @@ test_valid_colors_from_string(void **state)
 	assert_int_equal(color.b * UINT8_MAX, 0xEF);
 }
 
+void
+test_colors_are_packed_premultiplied(void **state)
+{
+	(void) state;
+	struct wob_colors colors;
+	assert_true(wob_color_from_rgba_string("123456", &colors.background));
+	assert_true(wob_color_from_rgba_string("FFFFFF00", &colors.border));
+	assert_true(wob_color_from_rgba_string("FFFFFF", &colors.value));
+	wob_colors_pack(&colors);
+
+	assert_int_equal(colors.packed[WOB_PIXEL_FORMAT_ARGB8888].background, 0xFF123456);
+	assert_int_equal(colors.packed[WOB_PIXEL_FORMAT_ARGB8888].border, 0x00000000);
+	assert_int_equal(colors.packed[WOB_PIXEL_FORMAT_ARGB8888].value, 0xFFFFFFFF);
+
+	// fully transparent is black once the alpha channel is ignored
+	assert_int_equal(colors.packed[WOB_PIXEL_FORMAT_XRGB8888].background, 0xFF123456);
+	assert_int_equal(colors.packed[WOB_PIXEL_FORMAT_XRGB8888].border, 0xFF000000);
+	assert_int_equal(colors.packed[WOB_PIXEL_FORMAT_XRGB8888].value, 0xFFFFFFFF);
+}
+
 int
 main(void)
 {
@@ -94,6 +114,7 @@ main(void)
 		cmocka_unit_test(test_string_with_invalid_length_fails),
 		cmocka_unit_test(test_string_with_invalid_characters_fails),
 		cmocka_unit_test(test_valid_colors_from_string),
+		cmocka_unit_test(test_colors_are_packed_premultiplied),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
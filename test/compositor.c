@@ -0,0 +1,840 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+
+#include "compositor.h"
+#include "fractional-scale-v1-server.h"
+#include "viewporter-server.h"
+#include "wlr-layer-shell-unstable-v1-server.h"
+
+struct test_layer_surface;
+
+struct test_surface {
+	struct wob_test_compositor *compositor;
+	struct wl_resource *resource;
+	struct test_layer_surface *layer_surface;
+	// NULL until it gets a layer surface, or when there are too many of them
+	struct wob_test_compositor_surface_stats *stats;
+
+	bool pending_attach;
+	struct wl_resource *pending_buffer;
+	struct wl_array pending_damage;
+	struct wl_list pending_frame_callbacks;
+
+	bool mapped;
+	bool entered;
+};
+
+struct test_layer_surface {
+	struct wl_resource *resource;
+	struct test_surface *surface;
+	// output it was created for, NULL when left to the compositor
+	struct wl_resource *output;
+
+	uint32_t width;
+	uint32_t height;
+	// surface has to be configured again after its size changed or it got unmapped
+	bool configured;
+	uint32_t configured_width;
+	uint32_t configured_height;
+	struct wl_list link;
+};
+
+struct held_buffer {
+	struct wob_test_compositor *compositor;
+	struct wl_resource *resource;
+	struct wl_listener destroy;
+	// content at commit, it has to be the same when the buffer is released
+	uint32_t *content;
+	size_t width;
+	size_t height;
+	unsigned int frames;
+	struct wl_list link;
+};
+
+void
+resource_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	(void) client;
+
+	wl_resource_destroy(resource);
+}
+
+void
+resource_unlink(struct wl_resource *resource)
+{
+	wl_list_remove(wl_resource_get_link(resource));
+}
+
+struct wl_resource *
+resource_create(struct wl_client *client, const struct wl_interface *interface, int version, uint32_t id)
+{
+	struct wl_resource *resource = wl_resource_create(client, interface, version, id);
+	if (resource == NULL) {
+		wl_client_post_no_memory(client);
+	}
+
+	return resource;
+}
+
+uint32_t
+now_msec(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t) (now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+void
+copy_shm_buffer(struct wl_shm_buffer *shm_buffer, uint32_t **buffer, size_t *buffer_width, size_t *buffer_height)
+{
+	size_t width = wl_shm_buffer_get_width(shm_buffer);
+	size_t height = wl_shm_buffer_get_height(shm_buffer);
+	size_t stride = wl_shm_buffer_get_stride(shm_buffer);
+	if (*buffer == NULL || *buffer_width != width || *buffer_height != height) {
+		free(*buffer);
+		*buffer = calloc(width * height, sizeof(uint32_t));
+		if (*buffer == NULL) {
+			fprintf(stderr, "calloc failed\n");
+			abort();
+		}
+		*buffer_width = width;
+		*buffer_height = height;
+	}
+
+	wl_shm_buffer_begin_access(shm_buffer);
+	const char *data = wl_shm_buffer_get_data(shm_buffer);
+	for (size_t y = 0; y < height; ++y) {
+		memcpy(*buffer + y * width, data + y * stride, width * sizeof(uint32_t));
+	}
+	wl_shm_buffer_end_access(shm_buffer);
+}
+
+void
+held_buffer_free(struct held_buffer *held)
+{
+	wl_list_remove(&held->destroy.link);
+	wl_list_remove(&held->link);
+	free(held->content);
+	free(held);
+}
+
+void
+held_buffer_handle_destroy(struct wl_listener *listener, void *data)
+{
+	(void) data;
+
+	struct held_buffer *held = wl_container_of(listener, held, destroy);
+	held->compositor->stats.busy_destroys += 1;
+	held_buffer_free(held);
+}
+
+void
+held_buffer_check(struct held_buffer *held)
+{
+	uint32_t *content = NULL;
+	size_t width = 0;
+	size_t height = 0;
+	copy_shm_buffer(wl_shm_buffer_get(held->resource), &content, &width, &height);
+	if (width != held->width || height != held->height || memcmp(content, held->content, width * height * sizeof(uint32_t)) != 0) {
+		held->compositor->stats.busy_overwrites += 1;
+	}
+	free(content);
+}
+
+void
+hold_buffer(struct wob_test_compositor *compositor, struct wl_resource *buffer_resource)
+{
+	if (wl_shm_buffer_get(buffer_resource) == NULL) {
+		wl_buffer_send_release(buffer_resource);
+		return;
+	}
+
+	// attached again while held, by another surface or unchanged, the content still has to be what was committed first
+	struct held_buffer *held;
+	wl_list_for_each (held, &compositor->held_buffers, link) {
+		if (held->resource == buffer_resource) {
+			held_buffer_check(held);
+			held->frames = compositor->hold_buffer_frames;
+			return;
+		}
+	}
+
+	held = calloc(1, sizeof(struct held_buffer));
+	if (held == NULL) {
+		fprintf(stderr, "calloc failed\n");
+		abort();
+	}
+
+	held->compositor = compositor;
+	held->resource = buffer_resource;
+	held->frames = compositor->hold_buffer_frames;
+	copy_shm_buffer(wl_shm_buffer_get(buffer_resource), &held->content, &held->width, &held->height);
+	held->destroy.notify = held_buffer_handle_destroy;
+	wl_resource_add_destroy_listener(buffer_resource, &held->destroy);
+	wl_list_insert(&compositor->held_buffers, &held->link);
+
+	unsigned long held_count = wl_list_length(&compositor->held_buffers);
+	if (held_count > compositor->stats.held_buffers_max) {
+		compositor->stats.held_buffers_max = held_count;
+	}
+}
+
+void
+surface_record_buffer(struct test_surface *surface, struct wl_resource *buffer_resource)
+{
+	struct wob_test_compositor_stats *stats = &surface->compositor->stats;
+
+	struct wl_shm_buffer *shm_buffer = wl_shm_buffer_get(buffer_resource);
+	if (shm_buffer == NULL) {
+		return;
+	}
+
+	size_t width = wl_shm_buffer_get_width(shm_buffer);
+	size_t height = wl_shm_buffer_get_height(shm_buffer);
+	copy_shm_buffer(shm_buffer, &stats->buffer, &stats->buffer_width, &stats->buffer_height);
+	if (surface->stats != NULL) {
+		copy_shm_buffer(shm_buffer, &surface->stats->buffer, &surface->stats->buffer_width, &surface->stats->buffer_height);
+		surface->stats->buffer_id = wl_resource_get_id(buffer_resource);
+		surface->stats->buffer_commits += 1;
+	}
+
+	struct wob_test_compositor_damage *damage;
+	wl_array_for_each (damage, &surface->pending_damage) {
+		int64_t x1 = damage->x < 0 ? 0 : damage->x;
+		int64_t y1 = damage->y < 0 ? 0 : damage->y;
+		int64_t x2 = (int64_t) damage->x + damage->width;
+		int64_t y2 = (int64_t) damage->y + damage->height;
+		x2 = x2 > (int64_t) width ? (int64_t) width : x2;
+		y2 = y2 > (int64_t) height ? (int64_t) height : y2;
+		if (x2 > x1 && y2 > y1) {
+			stats->damaged_pixels += (uint64_t) ((x2 - x1) * (y2 - y1));
+		}
+	}
+}
+
+void
+layer_surface_send_configure(struct test_layer_surface *layer_surface)
+{
+	struct wob_test_compositor *compositor = layer_surface->surface->compositor;
+
+	// size 0 means the client leaves it up to the compositor
+	uint32_t width = layer_surface->width != 0 ? layer_surface->width : compositor->output_width;
+	uint32_t height = layer_surface->height != 0 ? layer_surface->height : compositor->output_height;
+
+	zwlr_layer_surface_v1_send_configure(layer_surface->resource, compositor->next_serial++, width, height);
+	layer_surface->configured = true;
+	layer_surface->configured_width = layer_surface->width;
+	layer_surface->configured_height = layer_surface->height;
+	compositor->stats.configures += 1;
+}
+
+void
+surface_handle_attach(struct wl_client *client, struct wl_resource *resource, struct wl_resource *buffer, int32_t x, int32_t y)
+{
+	(void) client;
+	(void) x;
+	(void) y;
+
+	struct test_surface *surface = wl_resource_get_user_data(resource);
+	surface->pending_attach = true;
+	surface->pending_buffer = buffer;
+}
+
+void
+surface_handle_damage(struct wl_client *client, struct wl_resource *resource, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+	(void) client;
+
+	struct test_surface *surface = wl_resource_get_user_data(resource);
+	struct wob_test_compositor_damage *damage = wl_array_add(&surface->pending_damage, sizeof(struct wob_test_compositor_damage));
+	if (damage == NULL) {
+		wl_resource_post_no_memory(resource);
+		return;
+	}
+
+	*damage = (struct wob_test_compositor_damage) {.x = x, .y = y, .width = width, .height = height};
+}
+
+void
+surface_handle_frame(struct wl_client *client, struct wl_resource *resource, uint32_t callback)
+{
+	struct test_surface *surface = wl_resource_get_user_data(resource);
+
+	struct wl_resource *callback_resource = resource_create(client, &wl_callback_interface, 1, callback);
+	if (callback_resource == NULL) {
+		return;
+	}
+
+	wl_resource_set_implementation(callback_resource, NULL, NULL, resource_unlink);
+	wl_list_insert(surface->pending_frame_callbacks.prev, wl_resource_get_link(callback_resource));
+}
+
+void
+surface_handle_commit(struct wl_client *client, struct wl_resource *resource)
+{
+	struct test_surface *surface = wl_resource_get_user_data(resource);
+	struct wob_test_compositor *compositor = surface->compositor;
+	struct test_layer_surface *layer_surface = surface->layer_surface;
+
+	compositor->stats.commits += 1;
+
+	if (surface->pending_attach) {
+		if (surface->pending_buffer == NULL) {
+			// unmapped layer surface goes back to the state right after get_layer_surface
+			surface->mapped = false;
+			if (layer_surface != NULL) {
+				layer_surface->configured = false;
+			}
+		}
+		else {
+			if (layer_surface != NULL && !layer_surface->configured) {
+				wl_resource_post_error(layer_surface->resource, ZWLR_LAYER_SURFACE_V1_ERROR_INVALID_SURFACE_STATE, "buffer attached to an unconfigured layer surface");
+				return;
+			}
+
+			surface_record_buffer(surface, surface->pending_buffer);
+			compositor->stats.buffer_commits += 1;
+			surface->mapped = true;
+
+			// shm content was copied, so the buffer is released right away like GPU compositors do after upload, unless the test holds it
+			if (compositor->hold_buffer_frames > 0) {
+				hold_buffer(compositor, surface->pending_buffer);
+			}
+			else {
+				wl_buffer_send_release(surface->pending_buffer);
+			}
+
+			if (!surface->entered) {
+				// surface without an output of its own shows up on the first one
+				struct wl_resource *output = layer_surface != NULL ? layer_surface->output : NULL;
+				struct wl_resource *output_resource;
+				wl_resource_for_each (output_resource, &compositor->output_resources) {
+					if (wl_resource_get_client(output_resource) == client && (output == NULL || output == output_resource)) {
+						wl_surface_send_enter(resource, output_resource);
+						surface->entered = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+	else if (layer_surface != NULL) {
+		// initial commit without a buffer and changed size both ask for a new configure
+		bool resized = layer_surface->width != layer_surface->configured_width || layer_surface->height != layer_surface->configured_height;
+		if (!layer_surface->configured || resized) {
+			layer_surface_send_configure(layer_surface);
+		}
+	}
+
+	compositor->stats.mapped = surface->mapped;
+	surface->pending_attach = false;
+	surface->pending_buffer = NULL;
+	surface->pending_damage.size = 0;
+	wl_list_insert_list(compositor->frame_callbacks.prev, &surface->pending_frame_callbacks);
+	wl_list_init(&surface->pending_frame_callbacks);
+}
+
+void
+surface_handle_set_region(struct wl_client *client, struct wl_resource *resource, struct wl_resource *region)
+{
+	(void) client;
+	(void) resource;
+	(void) region;
+}
+
+void
+surface_handle_set_int(struct wl_client *client, struct wl_resource *resource, int32_t value)
+{
+	(void) client;
+	(void) resource;
+	(void) value;
+}
+
+void
+surface_handle_offset(struct wl_client *client, struct wl_resource *resource, int32_t x, int32_t y)
+{
+	(void) client;
+	(void) resource;
+	(void) x;
+	(void) y;
+}
+
+void
+surface_destroy(struct wl_resource *resource)
+{
+	struct test_surface *surface = wl_resource_get_user_data(resource);
+
+	struct wl_resource *callback, *callback_tmp;
+	wl_resource_for_each_safe (callback, callback_tmp, &surface->pending_frame_callbacks) {
+		wl_resource_destroy(callback);
+	}
+
+	if (surface->layer_surface != NULL) {
+		surface->layer_surface->surface = NULL;
+	}
+	if (surface->mapped) {
+		surface->compositor->stats.mapped = false;
+	}
+
+	wl_array_release(&surface->pending_damage);
+	free(surface);
+}
+
+void
+region_handle_rect(struct wl_client *client, struct wl_resource *resource, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+	(void) client;
+	(void) resource;
+	(void) x;
+	(void) y;
+	(void) width;
+	(void) height;
+}
+
+void
+compositor_handle_create_surface(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	static const struct wl_surface_interface surface_implementation = {
+		.destroy = resource_destroy,
+		.attach = surface_handle_attach,
+		.damage = surface_handle_damage,
+		.frame = surface_handle_frame,
+		.set_opaque_region = surface_handle_set_region,
+		.set_input_region = surface_handle_set_region,
+		.commit = surface_handle_commit,
+		.set_buffer_transform = surface_handle_set_int,
+		.set_buffer_scale = surface_handle_set_int,
+		.damage_buffer = surface_handle_damage,
+		.offset = surface_handle_offset,
+	};
+
+	struct test_surface *surface = calloc(1, sizeof(struct test_surface));
+	if (surface == NULL) {
+		wl_client_post_no_memory(client);
+		return;
+	}
+
+	surface->resource = resource_create(client, &wl_surface_interface, wl_resource_get_version(resource), id);
+	if (surface->resource == NULL) {
+		free(surface);
+		return;
+	}
+
+	surface->compositor = wl_resource_get_user_data(resource);
+	wl_array_init(&surface->pending_damage);
+	wl_list_init(&surface->pending_frame_callbacks);
+	wl_resource_set_implementation(surface->resource, &surface_implementation, surface, surface_destroy);
+}
+
+void
+compositor_handle_create_region(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	static const struct wl_region_interface region_implementation = {
+		.destroy = resource_destroy,
+		.add = region_handle_rect,
+		.subtract = region_handle_rect,
+	};
+
+	struct wl_resource *region = resource_create(client, &wl_region_interface, 1, id);
+	if (region != NULL) {
+		wl_resource_set_implementation(region, &region_implementation, NULL, NULL);
+	}
+}
+
+void
+compositor_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	static const struct wl_compositor_interface compositor_implementation = {
+		.create_surface = compositor_handle_create_surface,
+		.create_region = compositor_handle_create_region,
+	};
+
+	struct wl_resource *resource = resource_create(client, &wl_compositor_interface, version, id);
+	if (resource != NULL) {
+		wl_resource_set_implementation(resource, &compositor_implementation, data, NULL);
+	}
+}
+
+void
+output_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	static const struct wl_output_interface output_implementation = {
+		.release = resource_destroy,
+	};
+
+	struct wob_test_compositor_output *output = data;
+	struct wob_test_compositor *compositor = output->compositor;
+
+	struct wl_resource *resource = resource_create(client, &wl_output_interface, version, id);
+	if (resource == NULL) {
+		return;
+	}
+
+	wl_resource_set_implementation(resource, &output_implementation, output, resource_unlink);
+	wl_list_insert(&compositor->output_resources, wl_resource_get_link(resource));
+
+	wl_output_send_geometry(resource, 0, 0, 600, 340, WL_OUTPUT_SUBPIXEL_UNKNOWN, "wob", "test output", WL_OUTPUT_TRANSFORM_NORMAL);
+	wl_output_send_mode(resource, WL_OUTPUT_MODE_CURRENT, compositor->output_width, compositor->output_height, 60000);
+	if (version >= WL_OUTPUT_SCALE_SINCE_VERSION) {
+		wl_output_send_scale(resource, 1);
+	}
+	if (version >= WL_OUTPUT_NAME_SINCE_VERSION) {
+		wl_output_send_name(resource, output->name);
+	}
+	if (version >= WL_OUTPUT_DESCRIPTION_SINCE_VERSION) {
+		wl_output_send_description(resource, "wob test output");
+	}
+	if (version >= WL_OUTPUT_DONE_SINCE_VERSION) {
+		wl_output_send_done(resource);
+	}
+}
+
+void
+layer_surface_handle_set_size(struct wl_client *client, struct wl_resource *resource, uint32_t width, uint32_t height)
+{
+	(void) client;
+
+	struct test_layer_surface *layer_surface = wl_resource_get_user_data(resource);
+	layer_surface->width = width;
+	layer_surface->height = height;
+}
+
+void
+layer_surface_handle_set_uint(struct wl_client *client, struct wl_resource *resource, uint32_t value)
+{
+	(void) client;
+	(void) resource;
+	(void) value;
+}
+
+void
+layer_surface_handle_set_exclusive_zone(struct wl_client *client, struct wl_resource *resource, int32_t zone)
+{
+	(void) client;
+	(void) resource;
+	(void) zone;
+}
+
+void
+layer_surface_handle_set_margin(struct wl_client *client, struct wl_resource *resource, int32_t top, int32_t right, int32_t bottom, int32_t left)
+{
+	(void) client;
+	(void) resource;
+	(void) top;
+	(void) right;
+	(void) bottom;
+	(void) left;
+}
+
+void
+layer_surface_handle_get_popup(struct wl_client *client, struct wl_resource *resource, struct wl_resource *popup)
+{
+	(void) client;
+	(void) resource;
+	(void) popup;
+}
+
+void
+layer_surface_destroy(struct wl_resource *resource)
+{
+	struct test_layer_surface *layer_surface = wl_resource_get_user_data(resource);
+	if (layer_surface->surface != NULL) {
+		layer_surface->surface->layer_surface = NULL;
+	}
+
+	wl_list_remove(&layer_surface->link);
+	free(layer_surface);
+}
+
+void
+layer_shell_handle_get_layer_surface(
+	struct wl_client *client, struct wl_resource *resource, uint32_t id, struct wl_resource *surface_resource, struct wl_resource *output, uint32_t layer, const char *namespace
+)
+{
+	(void) layer;
+	(void) namespace;
+
+	static const struct zwlr_layer_surface_v1_interface layer_surface_implementation = {
+		.set_size = layer_surface_handle_set_size,
+		.set_anchor = layer_surface_handle_set_uint,
+		.set_exclusive_zone = layer_surface_handle_set_exclusive_zone,
+		.set_margin = layer_surface_handle_set_margin,
+		.set_keyboard_interactivity = layer_surface_handle_set_uint,
+		.get_popup = layer_surface_handle_get_popup,
+		.ack_configure = layer_surface_handle_set_uint,
+		.destroy = resource_destroy,
+		.set_layer = layer_surface_handle_set_uint,
+	};
+
+	struct test_surface *surface = wl_resource_get_user_data(surface_resource);
+	if (surface->layer_surface != NULL) {
+		wl_resource_post_error(resource, ZWLR_LAYER_SHELL_V1_ERROR_ALREADY_CONSTRUCTED, "surface already has a layer surface");
+		return;
+	}
+
+	struct test_layer_surface *layer_surface = calloc(1, sizeof(struct test_layer_surface));
+	if (layer_surface == NULL) {
+		wl_client_post_no_memory(client);
+		return;
+	}
+
+	layer_surface->resource = resource_create(client, &zwlr_layer_surface_v1_interface, wl_resource_get_version(resource), id);
+	if (layer_surface->resource == NULL) {
+		free(layer_surface);
+		return;
+	}
+
+	layer_surface->surface = surface;
+	layer_surface->output = output;
+	surface->layer_surface = layer_surface;
+	wl_list_insert(&surface->compositor->layer_surfaces, &layer_surface->link);
+
+	struct wob_test_compositor_stats *stats = &surface->compositor->stats;
+	if (stats->surfaces_count < WOB_TEST_COMPOSITOR_MAX_SURFACES) {
+		surface->stats = &stats->surfaces[stats->surfaces_count++];
+		if (output != NULL) {
+			struct wob_test_compositor_output *test_output = wl_resource_get_user_data(output);
+			surface->stats->output_name = test_output->name;
+		}
+	}
+	wl_resource_set_implementation(layer_surface->resource, &layer_surface_implementation, layer_surface, layer_surface_destroy);
+}
+
+void
+layer_shell_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	static const struct zwlr_layer_shell_v1_interface layer_shell_implementation = {
+		.get_layer_surface = layer_shell_handle_get_layer_surface,
+	};
+
+	struct wl_resource *resource = resource_create(client, &zwlr_layer_shell_v1_interface, version, id);
+	if (resource != NULL) {
+		wl_resource_set_implementation(resource, &layer_shell_implementation, data, NULL);
+	}
+}
+
+void
+viewport_handle_set_source(struct wl_client *client, struct wl_resource *resource, wl_fixed_t x, wl_fixed_t y, wl_fixed_t width, wl_fixed_t height)
+{
+	(void) client;
+	(void) resource;
+	(void) x;
+	(void) y;
+	(void) width;
+	(void) height;
+}
+
+void
+viewport_handle_set_destination(struct wl_client *client, struct wl_resource *resource, int32_t width, int32_t height)
+{
+	(void) client;
+	(void) resource;
+	(void) width;
+	(void) height;
+}
+
+void
+viewporter_handle_get_viewport(struct wl_client *client, struct wl_resource *resource, uint32_t id, struct wl_resource *surface)
+{
+	(void) surface;
+
+	static const struct wp_viewport_interface viewport_implementation = {
+		.destroy = resource_destroy,
+		.set_source = viewport_handle_set_source,
+		.set_destination = viewport_handle_set_destination,
+	};
+
+	struct wl_resource *viewport = resource_create(client, &wp_viewport_interface, wl_resource_get_version(resource), id);
+	if (viewport != NULL) {
+		wl_resource_set_implementation(viewport, &viewport_implementation, NULL, NULL);
+	}
+}
+
+void
+viewporter_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	static const struct wp_viewporter_interface viewporter_implementation = {
+		.destroy = resource_destroy,
+		.get_viewport = viewporter_handle_get_viewport,
+	};
+
+	struct wl_resource *resource = resource_create(client, &wp_viewporter_interface, version, id);
+	if (resource != NULL) {
+		wl_resource_set_implementation(resource, &viewporter_implementation, data, NULL);
+	}
+}
+
+void
+fractional_scale_manager_handle_get_fractional_scale(struct wl_client *client, struct wl_resource *resource, uint32_t id, struct wl_resource *surface)
+{
+	(void) surface;
+
+	static const struct wp_fractional_scale_v1_interface fractional_scale_implementation = {
+		.destroy = resource_destroy,
+	};
+
+	struct wob_test_compositor *compositor = wl_resource_get_user_data(resource);
+
+	struct wl_resource *fractional_scale = resource_create(client, &wp_fractional_scale_v1_interface, wl_resource_get_version(resource), id);
+	if (fractional_scale == NULL) {
+		return;
+	}
+
+	wl_resource_set_implementation(fractional_scale, &fractional_scale_implementation, NULL, resource_unlink);
+	wl_list_insert(&compositor->fractional_scales, wl_resource_get_link(fractional_scale));
+	wp_fractional_scale_v1_send_preferred_scale(fractional_scale, compositor->scale);
+}
+
+void
+fractional_scale_manager_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	static const struct wp_fractional_scale_manager_v1_interface fractional_scale_manager_implementation = {
+		.destroy = resource_destroy,
+		.get_fractional_scale = fractional_scale_manager_handle_get_fractional_scale,
+	};
+
+	struct wl_resource *resource = resource_create(client, &wp_fractional_scale_manager_v1_interface, version, id);
+	if (resource != NULL) {
+		wl_resource_set_implementation(resource, &fractional_scale_manager_implementation, data, NULL);
+	}
+}
+
+bool
+wob_test_compositor_add_output(struct wob_test_compositor *compositor)
+{
+	if (compositor->outputs_count == WOB_TEST_COMPOSITOR_MAX_OUTPUTS) {
+		return false;
+	}
+
+	struct wob_test_compositor_output *output = &compositor->outputs[compositor->outputs_count];
+	output->compositor = compositor;
+	snprintf(output->name, sizeof(output->name), "TEST-%zu", compositor->outputs_count + 1);
+	if (wl_global_create(compositor->wl_display, &wl_output_interface, 4, output, output_bind) == NULL) {
+		return false;
+	}
+	compositor->outputs_count += 1;
+
+	return true;
+}
+
+int
+refresh(void *data)
+{
+	struct wob_test_compositor *compositor = data;
+
+	// released before the frame callbacks, so the client can reuse them for the next frame
+	struct held_buffer *held, *held_tmp;
+	wl_list_for_each_safe (held, held_tmp, &compositor->held_buffers, link) {
+		held->frames -= 1;
+		if (held->frames == 0) {
+			held_buffer_check(held);
+			wl_buffer_send_release(held->resource);
+			held_buffer_free(held);
+		}
+	}
+
+	uint32_t time = now_msec();
+	struct wl_resource *callback, *callback_tmp;
+	wl_resource_for_each_safe (callback, callback_tmp, &compositor->frame_callbacks) {
+		wl_callback_send_done(callback, time);
+		wl_resource_destroy(callback);
+		compositor->stats.frame_callbacks += 1;
+	}
+
+	wl_event_source_timer_update(compositor->refresh_timer, WOB_TEST_COMPOSITOR_REFRESH_MSEC);
+
+	return 0;
+}
+
+struct wob_test_compositor *
+wob_test_compositor_create(void)
+{
+	struct wob_test_compositor *compositor = calloc(1, sizeof(struct wob_test_compositor));
+	if (compositor == NULL) {
+		return NULL;
+	}
+
+	compositor->output_width = 1920;
+	compositor->output_height = 1080;
+	compositor->scale = 120;
+	compositor->next_serial = 1;
+	wl_list_init(&compositor->output_resources);
+	wl_list_init(&compositor->fractional_scales);
+	wl_list_init(&compositor->layer_surfaces);
+	wl_list_init(&compositor->held_buffers);
+	wl_list_init(&compositor->frame_callbacks);
+
+	compositor->wl_display = wl_display_create();
+	if (compositor->wl_display == NULL) {
+		free(compositor);
+		return NULL;
+	}
+	compositor->wl_event_loop = wl_display_get_event_loop(compositor->wl_display);
+
+	compositor->socket = wl_display_add_socket_auto(compositor->wl_display);
+	if (compositor->socket == NULL || wl_display_init_shm(compositor->wl_display) != 0) {
+		wl_display_destroy(compositor->wl_display);
+		free(compositor);
+		return NULL;
+	}
+	wl_display_add_shm_format(compositor->wl_display, WL_SHM_FORMAT_ARGB8888);
+	wl_display_add_shm_format(compositor->wl_display, WL_SHM_FORMAT_XRGB8888);
+
+	if (wl_global_create(compositor->wl_display, &wl_compositor_interface, 4, compositor, compositor_bind) == NULL ||
+		wl_global_create(compositor->wl_display, &zwlr_layer_shell_v1_interface, 1, compositor, layer_shell_bind) == NULL ||
+		wl_global_create(compositor->wl_display, &wp_viewporter_interface, 1, compositor, viewporter_bind) == NULL ||
+		wl_global_create(compositor->wl_display, &wp_fractional_scale_manager_v1_interface, 1, compositor, fractional_scale_manager_bind) == NULL ||
+		!wob_test_compositor_add_output(compositor)) {
+		wl_display_destroy(compositor->wl_display);
+		free(compositor);
+		return NULL;
+	}
+
+	compositor->refresh_timer = wl_event_loop_add_timer(compositor->wl_event_loop, refresh, compositor);
+	if (compositor->refresh_timer == NULL) {
+		wl_display_destroy(compositor->wl_display);
+		free(compositor);
+		return NULL;
+	}
+	wl_event_source_timer_update(compositor->refresh_timer, WOB_TEST_COMPOSITOR_REFRESH_MSEC);
+
+	return compositor;
+}
+
+void
+wob_test_compositor_set_scale(struct wob_test_compositor *compositor, uint32_t scale)
+{
+	compositor->scale = scale;
+
+	struct wl_resource *fractional_scale;
+	wl_resource_for_each (fractional_scale, &compositor->fractional_scales) {
+		wp_fractional_scale_v1_send_preferred_scale(fractional_scale, scale);
+	}
+
+	// unconfigured ones get the new scale with their first configure anyway
+	struct test_layer_surface *layer_surface;
+	wl_list_for_each (layer_surface, &compositor->layer_surfaces, link) {
+		if (layer_surface->configured) {
+			layer_surface_send_configure(layer_surface);
+		}
+	}
+}
+
+void
+wob_test_compositor_destroy(struct wob_test_compositor *compositor)
+{
+	wl_display_destroy_clients(compositor->wl_display);
+	wl_event_source_remove(compositor->refresh_timer);
+	wl_display_destroy(compositor->wl_display);
+
+	free(compositor->stats.buffer);
+	for (size_t i = 0; i < compositor->stats.surfaces_count; ++i) {
+		free(compositor->stats.surfaces[i].buffer);
+	}
+	free(compositor);
+}
@@ -0,0 +1,99 @@
+#ifndef _WOB_TEST_COMPOSITOR_H
+#define _WOB_TEST_COMPOSITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <wayland-server-core.h>
+
+// how often frame callbacks are completed, emulates 60 Hz output
+#define WOB_TEST_COMPOSITOR_REFRESH_MSEC 16
+#define WOB_TEST_COMPOSITOR_MAX_OUTPUTS 4
+// layer surfaces that get their own stats, later ones are only counted in the totals
+#define WOB_TEST_COMPOSITOR_MAX_SURFACES 8
+
+struct wob_test_compositor_damage {
+	int32_t x;
+	int32_t y;
+	int32_t width;
+	int32_t height;
+};
+
+struct wob_test_compositor_surface_stats {
+	// name of the output the layer surface was created for, NULL when left to the compositor
+	const char *output_name;
+	unsigned long buffer_commits;
+	// protocol id of the last attached wl_buffer, surfaces attaching the same buffer have the same id
+	uint32_t buffer_id;
+	// copy of the last attached shm buffer
+	uint32_t *buffer;
+	size_t buffer_width;
+	size_t buffer_height;
+};
+
+struct wob_test_compositor_stats {
+	unsigned long commits;
+	// commits that attached a new non-NULL buffer
+	unsigned long buffer_commits;
+	unsigned long configures;
+	unsigned long frame_callbacks;
+	// sum of damaged areas, clamped to the buffer
+	uint64_t damaged_pixels;
+	// copy of the last attached shm buffer
+	uint32_t *buffer;
+	size_t buffer_width;
+	size_t buffer_height;
+	bool mapped;
+	// most buffers held at once, and held buffers whose content changed before they were released, which a client must never do
+	unsigned long held_buffers_max;
+	unsigned long busy_overwrites;
+	// held buffers destroyed before they were released, their storage may be reused while the compositor still reads it
+	unsigned long busy_destroys;
+	// per layer surface, in order of creation
+	struct wob_test_compositor_surface_stats surfaces[WOB_TEST_COMPOSITOR_MAX_SURFACES];
+	size_t surfaces_count;
+};
+
+struct wob_test_compositor_output {
+	struct wob_test_compositor *compositor;
+	char name[16];
+};
+
+struct wob_test_compositor {
+	struct wl_display *wl_display;
+	struct wl_event_loop *wl_event_loop;
+	const char *socket;
+
+	uint32_t output_width;
+	uint32_t output_height;
+	// preferred fractional scale, in 1/120 units
+	uint32_t scale;
+
+	// every output has the same mode, first one is created with the compositor
+	struct wob_test_compositor_output outputs[WOB_TEST_COMPOSITOR_MAX_OUTPUTS];
+	size_t outputs_count;
+	struct wl_list output_resources;
+	struct wl_list fractional_scales;
+	struct wl_list layer_surfaces;
+	// buffers are released this many refreshes after their commit instead of right away, like a compositor that keeps showing them
+	unsigned int hold_buffer_frames;
+	struct wl_list held_buffers;
+	// frame callbacks of committed surfaces, completed on the next refresh
+	struct wl_list frame_callbacks;
+	struct wl_event_source *refresh_timer;
+	uint32_t next_serial;
+
+	struct wob_test_compositor_stats stats;
+};
+
+struct wob_test_compositor *wob_test_compositor_create(void);
+
+// advertises one more output, named TEST-<number>
+bool wob_test_compositor_add_output(struct wob_test_compositor *compositor);
+
+// sends the new preferred scale to every surface and configures them again, like moving them to another output
+void wob_test_compositor_set_scale(struct wob_test_compositor *compositor, uint32_t scale);
+
+void wob_test_compositor_destroy(struct wob_test_compositor *compositor);
+
+#endif
@@ -0,0 +1,123 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "src/config.h"
+
+#define STYLES_COUNT 300
+
+struct config_file {
+	char path[sizeof("/tmp/wob-config-test-XXXXXX")];
+	struct wob_config *config;
+};
+
+int
+setup(void **state)
+{
+	struct config_file *file = calloc(1, sizeof(struct config_file));
+	if (file == NULL) {
+		return -1;
+	}
+
+	strcpy(file->path, "/tmp/wob-config-test-XXXXXX");
+	int fd = mkstemp(file->path);
+	FILE *stream = fd != -1 ? fdopen(fd, "w") : NULL;
+	if (stream == NULL) {
+		free(file);
+		return -1;
+	}
+
+	fputs("[output.laptop]\nmatch = eDP-1\n\n", stream);
+	fputs("[output.dell]\nmatch = DELL U2722DE\nwidth = 600\n\n", stream);
+	for (size_t i = 0; i < STYLES_COUNT; ++i) {
+		fprintf(stream, "[style.app%zu]\nbar_color = %06zX\n\n", i, i);
+	}
+	fclose(stream);
+
+	file->config = wob_config_create();
+	if (!wob_config_load(file->config, file->path)) {
+		return -1;
+	}
+	*state = file;
+
+	return 0;
+}
+
+int
+teardown(void **state)
+{
+	struct config_file *file = *state;
+	wob_config_destroy(file->config);
+	unlink(file->path);
+	free(file);
+
+	return 0;
+}
+
+void
+test_styles_are_found_by_name(void **state)
+{
+	struct config_file *file = *state;
+
+	for (size_t i = 0; i < STYLES_COUNT; ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "app%zu", i);
+
+		struct wob_style *style = wob_config_find_style(file->config, name);
+		assert_non_null(style);
+		assert_string_equal(style->name, name);
+		assert_int_equal(style->colors.packed[WOB_PIXEL_FORMAT_ARGB8888].value, 0xFF000000 | i);
+	}
+
+	assert_null(wob_config_find_style(file->config, "app"));
+	assert_null(wob_config_find_style(file->config, "app300"));
+	assert_null(wob_config_find_style(file->config, ""));
+}
+
+void
+test_outputs_are_found_by_id(void **state)
+{
+	struct config_file *file = *state;
+
+	struct wob_output_config *output_config = wob_config_find_output(file->config, "dell");
+	assert_non_null(output_config);
+	assert_int_equal(output_config->dimensions.width, 600);
+
+	assert_non_null(wob_config_find_output(file->config, "laptop"));
+	assert_null(wob_config_find_output(file->config, "DELL U2722DE"));
+}
+
+void
+test_output_match_is_a_substring(void **state)
+{
+	struct config_file *file = *state;
+
+	struct wob_output_config *output_config = wob_config_match_output(file->config, "Dell Inc. DELL U2722DE 5G9ZY83 (DP-2)");
+	assert_non_null(output_config);
+	assert_string_equal(output_config->id, "dell");
+
+	output_config = wob_config_match_output(file->config, "eDP-1");
+	assert_non_null(output_config);
+	assert_string_equal(output_config->id, "laptop");
+
+	assert_null(wob_config_match_output(file->config, "HDMI-A-1"));
+	assert_null(wob_config_match_output(file->config, "eDP"));
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_styles_are_found_by_name),
+		cmocka_unit_test(test_outputs_are_found_by_id),
+		cmocka_unit_test(test_output_match_is_a_substring),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
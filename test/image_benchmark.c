@@ -0,0 +1,132 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "src/image.h"
+#include "src/image_cache.h"
+
+// every case runs at least this long to get stable numbers
+#define MIN_CASE_DURATION_NSEC 50000000ULL
+
+struct benchmark_case {
+	const char *name;
+	struct wob_dimensions dimensions;
+};
+
+uint64_t
+now_nsec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+void
+draw(void *data, struct wob_dimensions dimensions, enum wob_pixel_format format, struct wob_packed_colors colors, double percentage, struct wob_image_cache *cache)
+{
+	if (cache != NULL) {
+		wob_image_cache_draw(cache, data, dimensions, format, colors, wob_image_bar_length(dimensions, percentage));
+	}
+	else {
+		wob_image_draw(data, dimensions, format, colors, percentage);
+	}
+}
+
+void
+benchmark(const char *name, struct wob_dimensions dimensions, uint32_t scale, double percentage, enum wob_pixel_format format, struct wob_colors colors, struct wob_image_cache *cache)
+{
+	struct wob_dimensions scaled = wob_dimensions_apply_scale(dimensions, scale);
+	size_t frame_size = scaled.width * scaled.height * wob_pixel_format_bytes(format);
+	void *data = malloc(frame_size);
+	if (data == NULL) {
+		fprintf(stderr, "malloc failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// warm up, so page faults are not part of the measurement
+	draw(data, scaled, format, colors.packed[format], percentage, cache);
+
+	uint64_t frames = 0;
+	uint64_t start = now_nsec();
+	uint64_t elapsed;
+	do {
+		for (size_t i = 0; i < 16; ++i) {
+			draw(data, scaled, format, colors.packed[format], percentage, cache);
+		}
+		frames += 16;
+		elapsed = now_nsec() - start;
+	} while (elapsed < MIN_CASE_DURATION_NSEC);
+
+	double nsec_per_frame = (double) elapsed / frames;
+	double mb_per_sec = (double) frame_size * frames / (elapsed / 1e9) / (1024 * 1024);
+
+	printf(
+		"%-10s %-8s %-6s %5lux%-5lu scale %.2f  %3.0f%%  %12.0f ns/frame  %10.1f MB/s\n",
+		name,
+		wob_pixel_format_name(format),
+		cache != NULL ? "cached" : "full",
+		scaled.width,
+		scaled.height,
+		scale / 120.,
+		percentage * 100,
+		nsec_per_frame,
+		mb_per_sec
+	);
+
+	free(data);
+}
+
+int
+main(void)
+{
+	const struct benchmark_case cases[] = {
+		{
+			.name = "default",
+			.dimensions = {.width = 400, .height = 50, .border_offset = 4, .border_size = 4, .bar_padding = 4, .orientation = WOB_ORIENTATION_HORIZONTAL},
+		},
+		{
+			.name = "wide",
+			.dimensions = {.width = 1200, .height = 150, .border_offset = 12, .border_size = 12, .bar_padding = 12, .orientation = WOB_ORIENTATION_HORIZONTAL},
+		},
+		{
+			.name = "vertical",
+			.dimensions = {.width = 50, .height = 400, .border_offset = 4, .border_size = 4, .bar_padding = 4, .orientation = WOB_ORIENTATION_VERTICAL},
+		},
+		{
+			.name = "tall",
+			.dimensions = {.width = 150, .height = 1200, .border_offset = 12, .border_size = 12, .bar_padding = 12, .orientation = WOB_ORIENTATION_VERTICAL},
+		},
+	};
+	// fractional scale in 1/120 units, same as wp_fractional_scale_v1
+	const uint32_t scales[] = {120, 180, 240, 360};
+	const double percentages[] = {0.0, 0.5, 1.0};
+	// xrgb8888 draws exactly like argb8888, only the packed pixels differ
+	const enum wob_pixel_format formats[] = {WOB_PIXEL_FORMAT_ARGB8888, WOB_PIXEL_FORMAT_RGB565};
+
+	struct wob_colors colors;
+	wob_color_from_rgba_string("000000", &colors.background);
+	wob_color_from_rgba_string("FFFFFF", &colors.border);
+	wob_color_from_rgba_string("FFFFFF", &colors.value);
+	wob_colors_pack(&colors);
+
+	// full draw against a copy of the cached chrome plus the bar fill
+	struct wob_image_cache cache;
+	wob_image_cache_init(&cache);
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		for (size_t j = 0; j < sizeof(scales) / sizeof(scales[0]); ++j) {
+			for (size_t k = 0; k < sizeof(percentages) / sizeof(percentages[0]); ++k) {
+				for (size_t l = 0; l < sizeof(formats) / sizeof(formats[0]); ++l) {
+					benchmark(cases[i].name, cases[i].dimensions, scales[j], percentages[k], formats[l], colors, NULL);
+					benchmark(cases[i].name, cases[i].dimensions, scales[j], percentages[k], formats[l], colors, &cache);
+				}
+			}
+		}
+	}
+
+	wob_image_cache_destroy(&cache);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "src/image.h"
+#include "src/image_cache.h"
+
+static const struct wob_dimensions dimensions = {
+	.width = 40,
+	.height = 12,
+	.border_offset = 1,
+	.border_size = 1,
+	.bar_padding = 1,
+	.orientation = WOB_ORIENTATION_HORIZONTAL,
+};
+
+static const struct wob_packed_colors colors = {
+	.background = 0xFF000000,
+	.border = 0xFFFFFFFF,
+	.value = 0x7F7F0000,
+};
+
+void
+test_cached_draw_matches_full_draw(void **state)
+{
+	struct wob_image_cache cache;
+	wob_image_cache_init(&cache);
+
+	uint32_t expected[40 * 12];
+	uint32_t actual[40 * 12];
+	const double percentages[] = {0.0, 0.25, 0.5, 1.0};
+	for (size_t i = 0; i < sizeof(percentages) / sizeof(percentages[0]); ++i) {
+		memset(actual, 0xAB, sizeof(actual));
+		wob_image_draw(expected, dimensions, WOB_PIXEL_FORMAT_ARGB8888, colors, percentages[i]);
+		wob_image_cache_draw(&cache, actual, dimensions, WOB_PIXEL_FORMAT_ARGB8888, colors, wob_image_bar_length(dimensions, percentages[i]));
+		assert_memory_equal(expected, actual, sizeof(expected));
+	}
+
+	// chrome is drawn once, every other frame is a copy
+	assert_int_equal(cache.misses, 1);
+	assert_int_equal(cache.hits, 3);
+
+	wob_image_cache_destroy(&cache);
+}
+
+void
+test_least_recently_used_is_evicted(void **state)
+{
+	struct wob_image_cache cache;
+	wob_image_cache_init(&cache);
+
+	struct wob_packed_colors keys[WOB_IMAGE_CACHE_SIZE + 1];
+	for (size_t i = 0; i < WOB_IMAGE_CACHE_SIZE + 1; ++i) {
+		keys[i] = colors;
+		keys[i].background = 0xFF000000 | (uint32_t) i;
+	}
+
+	for (size_t i = 0; i < WOB_IMAGE_CACHE_SIZE; ++i) {
+		assert_non_null(wob_image_cache_get(&cache, dimensions, WOB_PIXEL_FORMAT_ARGB8888, keys[i]));
+	}
+	assert_int_equal(cache.misses, WOB_IMAGE_CACHE_SIZE);
+
+	// first key is used again, so the second one is the oldest now
+	wob_image_cache_get(&cache, dimensions, WOB_PIXEL_FORMAT_ARGB8888, keys[0]);
+	assert_int_equal(cache.hits, 1);
+
+	wob_image_cache_get(&cache, dimensions, WOB_PIXEL_FORMAT_ARGB8888, keys[WOB_IMAGE_CACHE_SIZE]);
+	wob_image_cache_get(&cache, dimensions, WOB_PIXEL_FORMAT_ARGB8888, keys[0]);
+	assert_int_equal(cache.hits, 2);
+	wob_image_cache_get(&cache, dimensions, WOB_PIXEL_FORMAT_ARGB8888, keys[1]);
+	assert_int_equal(cache.misses, WOB_IMAGE_CACHE_SIZE + 2);
+
+	wob_image_cache_destroy(&cache);
+}
+
+void
+test_dimensions_are_part_of_the_key(void **state)
+{
+	struct wob_image_cache cache;
+	wob_image_cache_init(&cache);
+
+	struct wob_dimensions scaled = wob_dimensions_apply_scale(dimensions, 240);
+	uint32_t *expected = malloc(scaled.width * scaled.height * sizeof(uint32_t));
+	uint32_t *actual = malloc(scaled.width * scaled.height * sizeof(uint32_t));
+	assert_non_null(expected);
+	assert_non_null(actual);
+
+	wob_image_cache_get(&cache, dimensions, WOB_PIXEL_FORMAT_ARGB8888, colors);
+	wob_image_draw(expected, scaled, WOB_PIXEL_FORMAT_ARGB8888, colors, 0.5);
+	wob_image_cache_draw(&cache, actual, scaled, WOB_PIXEL_FORMAT_ARGB8888, colors, wob_image_bar_length(scaled, 0.5));
+	assert_memory_equal(expected, actual, scaled.width * scaled.height * sizeof(uint32_t));
+	assert_int_equal(cache.misses, 2);
+
+	free(expected);
+	free(actual);
+	wob_image_cache_destroy(&cache);
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_cached_draw_matches_full_draw),
+		cmocka_unit_test(test_least_recently_used_is_evicted),
+		cmocka_unit_test(test_dimensions_are_part_of_the_key),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,316 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "src/image.h"
+
+static const struct wob_dimensions horizontal = {
+	.width = 40,
+	.height = 12,
+	.border_offset = 1,
+	.border_size = 2,
+	.bar_padding = 1,
+	.orientation = WOB_ORIENTATION_HORIZONTAL,
+};
+
+static const struct wob_dimensions vertical = {
+	.width = 12,
+	.height = 40,
+	.border_offset = 1,
+	.border_size = 2,
+	.bar_padding = 1,
+	.orientation = WOB_ORIENTATION_VERTICAL,
+};
+
+static const double percentages[] = {0.0, 0.05, 0.5, 0.51, 0.99, 1.0};
+
+struct wob_colors
+test_colors(void)
+{
+	struct wob_colors colors;
+	wob_color_from_rgba_string("10203080", &colors.background);
+	wob_color_from_rgba_string("FFFFFF", &colors.border);
+	wob_color_from_rgba_string("A0B0C0F0", &colors.value);
+	wob_colors_pack(&colors);
+
+	return colors;
+}
+
+uint32_t
+test_pixel(struct wob_color color)
+{
+	return wob_color_to_argb(wob_color_premultiply_alpha(color));
+}
+
+void
+fill_reference(uint32_t *data, struct wob_dimensions dimensions, size_t offset_x, size_t offset_y, size_t width, size_t height, uint32_t color)
+{
+	for (size_t y = offset_y; y < offset_y + height; ++y) {
+		for (size_t x = offset_x; x < offset_x + width; ++x) {
+			data[y * dimensions.width + x] = color;
+		}
+	}
+}
+
+// layers background, border, inner background and the bar on top of each other
+void
+draw_reference(uint32_t *data, struct wob_dimensions dimensions, struct wob_colors colors, double percentage)
+{
+	size_t offsets[] = {
+		0,
+		dimensions.border_offset,
+		dimensions.border_offset + dimensions.border_size,
+	};
+	uint32_t layers[] = {
+		test_pixel(colors.background),
+		test_pixel(colors.border),
+		test_pixel(colors.background),
+	};
+
+	for (size_t i = 0; i < 3; ++i) {
+		fill_reference(data, dimensions, offsets[i], offsets[i], dimensions.width - 2 * offsets[i], dimensions.height - 2 * offsets[i], layers[i]);
+	}
+
+	size_t offset = dimensions.border_offset + dimensions.border_size + dimensions.bar_padding;
+	size_t bar_width = dimensions.width - 2 * offset;
+	size_t bar_height = dimensions.height - 2 * offset;
+	if (dimensions.orientation == WOB_ORIENTATION_HORIZONTAL) {
+		fill_reference(data, dimensions, offset, offset, (size_t) (bar_width * percentage), bar_height, test_pixel(colors.value));
+	}
+	else {
+		size_t height = bar_height * percentage;
+		fill_reference(data, dimensions, offset, offset + bar_height - height, bar_width, height, test_pixel(colors.value));
+	}
+}
+
+void
+assert_draw_matches_reference(struct wob_dimensions dimensions)
+{
+	struct wob_colors colors = test_colors();
+	struct wob_packed_colors pixels = colors.packed[WOB_PIXEL_FORMAT_ARGB8888];
+	size_t size = dimensions.width * dimensions.height;
+	uint32_t *expected = calloc(size, sizeof(uint32_t));
+	uint32_t *actual = calloc(size, sizeof(uint32_t));
+	assert_non_null(expected);
+	assert_non_null(actual);
+
+	for (size_t i = 0; i < sizeof(percentages) / sizeof(percentages[0]); ++i) {
+		draw_reference(expected, dimensions, colors, percentages[i]);
+		wob_image_draw(actual, dimensions, WOB_PIXEL_FORMAT_ARGB8888, pixels, percentages[i]);
+		assert_memory_equal(actual, expected, size * sizeof(uint32_t));
+	}
+
+	free(expected);
+	free(actual);
+}
+
+uint32_t
+pixel_at(const void *data, enum wob_pixel_format format, size_t index)
+{
+	if (wob_pixel_format_bytes(format) == 2) {
+		return ((const uint16_t *) data)[index];
+	}
+
+	return ((const uint32_t *) data)[index];
+}
+
+void
+assert_delta_matches_full_redraw(struct wob_dimensions dimensions, enum wob_pixel_format format)
+{
+	struct wob_colors colors = test_colors();
+	struct wob_packed_colors pixels = colors.packed[format];
+	size_t size = dimensions.width * dimensions.height * wob_pixel_format_bytes(format);
+	unsigned char *expected = calloc(size, 1);
+	unsigned char *previous = calloc(size, 1);
+	unsigned char *actual = calloc(size, 1);
+	assert_non_null(expected);
+	assert_non_null(previous);
+	assert_non_null(actual);
+
+	for (size_t i = 0; i < sizeof(percentages) / sizeof(percentages[0]); ++i) {
+		for (size_t j = 0; j < sizeof(percentages) / sizeof(percentages[0]); ++j) {
+			size_t from_length = wob_image_bar_length(dimensions, percentages[i]);
+			size_t to_length = wob_image_bar_length(dimensions, percentages[j]);
+
+			wob_image_draw(previous, dimensions, format, pixels, percentages[i]);
+			wob_image_draw(expected, dimensions, format, pixels, percentages[j]);
+
+			memcpy(actual, previous, size);
+			struct wob_image_rect rect = wob_image_draw_bar_delta(actual, dimensions, format, pixels, from_length, to_length);
+			assert_memory_equal(actual, expected, size);
+
+			// every changed pixel has to be covered by the damaged rectangle
+			for (size_t y = 0; y < dimensions.height; ++y) {
+				for (size_t x = 0; x < dimensions.width; ++x) {
+					size_t index = y * dimensions.width + x;
+					if (pixel_at(previous, format, index) != pixel_at(expected, format, index)) {
+						assert_true(x >= rect.x && x < rect.x + rect.width);
+						assert_true(y >= rect.y && y < rect.y + rect.height);
+					}
+				}
+			}
+		}
+	}
+
+	free(expected);
+	free(previous);
+	free(actual);
+}
+
+void
+assert_layout_matches_draw(struct wob_dimensions dimensions, enum wob_pixel_format format)
+{
+	struct wob_colors colors = test_colors();
+	uint32_t pixels[] = {
+		[WOB_IMAGE_COLOR_BACKGROUND] = colors.packed[format].background,
+		[WOB_IMAGE_COLOR_BORDER] = colors.packed[format].border,
+		[WOB_IMAGE_COLOR_VALUE] = colors.packed[format].value,
+	};
+
+	size_t size = dimensions.width * dimensions.height;
+	void *drawn = calloc(size, wob_pixel_format_bytes(format));
+	uint32_t *expected = calloc(size, sizeof(uint32_t));
+	uint32_t *actual = calloc(size, sizeof(uint32_t));
+	unsigned char *writes = calloc(size, sizeof(unsigned char));
+	assert_non_null(drawn);
+	assert_non_null(expected);
+	assert_non_null(actual);
+	assert_non_null(writes);
+
+	for (size_t i = 0; i < sizeof(percentages) / sizeof(percentages[0]); ++i) {
+		memset(writes, 0, size);
+		wob_image_draw(drawn, dimensions, format, colors.packed[format], percentages[i]);
+		for (size_t j = 0; j < size; ++j) {
+			expected[j] = pixel_at(drawn, format, j);
+		}
+
+		struct wob_image_part parts[WOB_IMAGE_PARTS_COUNT];
+		wob_image_layout(dimensions, wob_image_bar_length(dimensions, percentages[i]), parts);
+		for (size_t j = 0; j < WOB_IMAGE_PARTS_COUNT; ++j) {
+			struct wob_image_rect rect = parts[j].rect;
+			for (size_t y = rect.y; y < rect.y + rect.height; ++y) {
+				for (size_t x = rect.x; x < rect.x + rect.width; ++x) {
+					actual[y * dimensions.width + x] = pixels[parts[j].color];
+					writes[y * dimensions.width + x] += 1;
+				}
+			}
+		}
+
+		assert_memory_equal(actual, expected, size * sizeof(uint32_t));
+		// parts cover the whole image and don't overlap
+		for (size_t j = 0; j < size; ++j) {
+			assert_int_equal(writes[j], 1);
+		}
+	}
+
+	free(drawn);
+	free(expected);
+	free(actual);
+	free(writes);
+}
+
+void
+test_horizontal_layout_matches_draw(void **state)
+{
+	(void) state;
+	assert_layout_matches_draw(horizontal, WOB_PIXEL_FORMAT_ARGB8888);
+}
+
+void
+test_vertical_layout_matches_draw(void **state)
+{
+	(void) state;
+	assert_layout_matches_draw(vertical, WOB_PIXEL_FORMAT_ARGB8888);
+}
+
+void
+test_horizontal_draw_matches_reference(void **state)
+{
+	(void) state;
+	assert_draw_matches_reference(horizontal);
+}
+
+void
+test_vertical_draw_matches_reference(void **state)
+{
+	(void) state;
+	assert_draw_matches_reference(vertical);
+}
+
+void
+test_draw_without_padding_matches_reference(void **state)
+{
+	(void) state;
+	struct wob_dimensions dimensions = horizontal;
+	dimensions.border_offset = 0;
+	dimensions.bar_padding = 0;
+	assert_draw_matches_reference(dimensions);
+}
+
+void
+test_horizontal_delta_matches_full_redraw(void **state)
+{
+	(void) state;
+	assert_delta_matches_full_redraw(horizontal, WOB_PIXEL_FORMAT_ARGB8888);
+}
+
+void
+test_vertical_delta_matches_full_redraw(void **state)
+{
+	(void) state;
+	assert_delta_matches_full_redraw(vertical, WOB_PIXEL_FORMAT_ARGB8888);
+}
+
+void
+test_rgb565_layout_matches_draw(void **state)
+{
+	(void) state;
+	// odd width, so rows and spans start at 16-bit aligned addresses only
+	struct wob_dimensions dimensions = horizontal;
+	dimensions.width = 41;
+	assert_layout_matches_draw(dimensions, WOB_PIXEL_FORMAT_RGB565);
+	assert_layout_matches_draw(vertical, WOB_PIXEL_FORMAT_RGB565);
+}
+
+void
+test_rgb565_delta_matches_full_redraw(void **state)
+{
+	(void) state;
+	struct wob_dimensions dimensions = horizontal;
+	dimensions.width = 41;
+	assert_delta_matches_full_redraw(dimensions, WOB_PIXEL_FORMAT_RGB565);
+	assert_delta_matches_full_redraw(vertical, WOB_PIXEL_FORMAT_RGB565);
+}
+
+void
+test_unchanged_value_has_empty_delta(void **state)
+{
+	(void) state;
+	size_t length = wob_image_bar_length(horizontal, 0.5);
+	struct wob_image_rect rect = wob_image_bar_delta(horizontal, length, length);
+	assert_int_equal(rect.width, 0);
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_horizontal_draw_matches_reference),
+		cmocka_unit_test(test_vertical_draw_matches_reference),
+		cmocka_unit_test(test_draw_without_padding_matches_reference),
+		cmocka_unit_test(test_horizontal_layout_matches_draw),
+		cmocka_unit_test(test_vertical_layout_matches_draw),
+		cmocka_unit_test(test_horizontal_delta_matches_full_redraw),
+		cmocka_unit_test(test_vertical_delta_matches_full_redraw),
+		cmocka_unit_test(test_rgb565_layout_matches_draw),
+		cmocka_unit_test(test_rgb565_delta_matches_full_redraw),
+		cmocka_unit_test(test_unchanged_value_has_empty_delta),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,204 @@
+#include <limits.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "src/input.h"
+
+struct pipe_input {
+	int write_fd;
+	struct wob_input input;
+};
+
+int
+setup(void **state)
+{
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return -1;
+	}
+
+	struct pipe_input *pipe_input = malloc(sizeof(struct pipe_input));
+	if (pipe_input == NULL) {
+		return -1;
+	}
+
+	pipe_input->write_fd = fds[1];
+	wob_input_init(&pipe_input->input, fds[0]);
+	*state = pipe_input;
+
+	return 0;
+}
+
+int
+teardown(void **state)
+{
+	struct pipe_input *pipe_input = *state;
+	close(pipe_input->write_fd);
+	close(pipe_input->input.fd);
+	free(pipe_input);
+
+	return 0;
+}
+
+void
+test_burst_is_read_at_once(void **state)
+{
+	struct pipe_input *pipe_input = *state;
+	const char data[] = "10\n20 muted\n30\n";
+	assert_int_equal(write(pipe_input->write_fd, data, strlen(data)), strlen(data));
+
+	assert_int_equal(wob_input_read(&pipe_input->input), strlen(data));
+	assert_string_equal(wob_input_next_line(&pipe_input->input), "10");
+	assert_string_equal(wob_input_next_line(&pipe_input->input), "20 muted");
+	assert_string_equal(wob_input_next_line(&pipe_input->input), "30");
+	assert_null(wob_input_next_line(&pipe_input->input));
+}
+
+void
+test_partial_line_is_kept(void **state)
+{
+	struct pipe_input *pipe_input = *state;
+	assert_int_equal(write(pipe_input->write_fd, "10\n2", 4), 4);
+
+	assert_int_equal(wob_input_read(&pipe_input->input), 4);
+	assert_string_equal(wob_input_next_line(&pipe_input->input), "10");
+	assert_null(wob_input_next_line(&pipe_input->input));
+
+	assert_int_equal(write(pipe_input->write_fd, "0\n", 2), 2);
+
+	assert_int_equal(wob_input_read(&pipe_input->input), 2);
+	assert_string_equal(wob_input_next_line(&pipe_input->input), "20");
+	assert_null(wob_input_next_line(&pipe_input->input));
+}
+
+void
+test_too_long_line_is_discarded(void **state)
+{
+	struct pipe_input *pipe_input = *state;
+	char data[4096];
+	memset(data, '1', sizeof(data));
+
+	// fill the whole input buffer without a single newline
+	for (size_t i = 0; i < WOB_INPUT_BUFFER_LENGTH / sizeof(data); ++i) {
+		assert_int_equal(write(pipe_input->write_fd, data, sizeof(data)), sizeof(data));
+		assert_int_equal(wob_input_read(&pipe_input->input), sizeof(data));
+		assert_null(wob_input_next_line(&pipe_input->input));
+	}
+
+	assert_int_equal(write(pipe_input->write_fd, "1\n50\n", 5), 5);
+	assert_int_equal(wob_input_read(&pipe_input->input), 5);
+	assert_string_equal(wob_input_next_line(&pipe_input->input), "50");
+	assert_null(wob_input_next_line(&pipe_input->input));
+}
+
+void
+test_eof(void **state)
+{
+	struct pipe_input *pipe_input = *state;
+	close(pipe_input->write_fd);
+	pipe_input->write_fd = -1;
+
+	assert_int_equal(wob_input_read(&pipe_input->input), 0);
+	assert_null(wob_input_next_line(&pipe_input->input));
+	assert_null(wob_input_last_line(&pipe_input->input));
+}
+
+void
+test_last_line_without_newline(void **state)
+{
+	struct pipe_input *pipe_input = *state;
+	assert_int_equal(write(pipe_input->write_fd, "10\n20", 5), 5);
+	close(pipe_input->write_fd);
+	pipe_input->write_fd = -1;
+
+	assert_int_equal(wob_input_read(&pipe_input->input), 5);
+	assert_string_equal(wob_input_next_line(&pipe_input->input), "10");
+	assert_null(wob_input_next_line(&pipe_input->input));
+
+	assert_int_equal(wob_input_read(&pipe_input->input), 0);
+	assert_string_equal(wob_input_last_line(&pipe_input->input), "20");
+	assert_null(wob_input_last_line(&pipe_input->input));
+}
+
+void
+test_parse_value(void **state)
+{
+	enum wob_input_operation operation;
+	unsigned long amount;
+
+	assert_true(wob_input_parse_value("50", &operation, &amount));
+	assert_int_equal(operation, WOB_INPUT_OPERATION_SET);
+	assert_int_equal(amount, 50);
+
+	assert_true(wob_input_parse_value("=20", &operation, &amount));
+	assert_int_equal(operation, WOB_INPUT_OPERATION_SET);
+	assert_int_equal(amount, 20);
+
+	assert_true(wob_input_parse_value("+5", &operation, &amount));
+	assert_int_equal(operation, WOB_INPUT_OPERATION_INCREASE);
+	assert_int_equal(amount, 5);
+
+	assert_true(wob_input_parse_value("-5", &operation, &amount));
+	assert_int_equal(operation, WOB_INPUT_OPERATION_DECREASE);
+	assert_int_equal(amount, 5);
+
+	assert_false(wob_input_parse_value("", &operation, &amount));
+	assert_false(wob_input_parse_value("+", &operation, &amount));
+	assert_false(wob_input_parse_value("+-5", &operation, &amount));
+	assert_false(wob_input_parse_value("- 5", &operation, &amount));
+	assert_false(wob_input_parse_value("5x", &operation, &amount));
+}
+
+void
+test_apply_value(void **state)
+{
+	assert_int_equal(wob_input_apply_value(50, WOB_INPUT_OPERATION_INCREASE, 5, 100, false), 55);
+	assert_int_equal(wob_input_apply_value(50, WOB_INPUT_OPERATION_DECREASE, 5, 100, false), 45);
+	assert_int_equal(wob_input_apply_value(3, WOB_INPUT_OPERATION_DECREASE, 5, 100, false), 0);
+	assert_int_equal(wob_input_apply_value(98, WOB_INPUT_OPERATION_INCREASE, 5, 100, false), 100);
+	assert_int_equal(wob_input_apply_value(ULONG_MAX - 1, WOB_INPUT_OPERATION_INCREASE, 5, ULONG_MAX, false), ULONG_MAX);
+
+	// absolute values are not clamped, they can still overflow
+	assert_int_equal(wob_input_apply_value(50, WOB_INPUT_OPERATION_SET, 150, 100, false), 150);
+	assert_int_equal(wob_input_apply_value(50, WOB_INPUT_OPERATION_SET, 150, 100, true), 150);
+}
+
+void
+test_apply_value_wrap(void **state)
+{
+	assert_int_equal(wob_input_apply_value(50, WOB_INPUT_OPERATION_INCREASE, 5, 100, true), 55);
+	assert_int_equal(wob_input_apply_value(95, WOB_INPUT_OPERATION_INCREASE, 5, 100, true), 100);
+	assert_int_equal(wob_input_apply_value(3, WOB_INPUT_OPERATION_DECREASE, 5, 100, true), 0);
+
+	// step past max wraps like an absolute value is shown, max + 20 as 20
+	assert_int_equal(wob_input_apply_value(98, WOB_INPUT_OPERATION_INCREASE, 22, 100, true), 20);
+	assert_int_equal(wob_input_apply_value(98, WOB_INPUT_OPERATION_INCREASE, 5, 100, true), 3);
+
+	// overflowing absolute value is brought back into range by the next step
+	assert_int_equal(wob_input_apply_value(150, WOB_INPUT_OPERATION_INCREASE, 5, 100, true), 55);
+	assert_int_equal(wob_input_apply_value(150, WOB_INPUT_OPERATION_DECREASE, 5, 100, true), 45);
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_burst_is_read_at_once, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_partial_line_is_kept, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_too_long_line_is_discarded, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_eof, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_last_line_without_newline, setup, teardown),
+		cmocka_unit_test(test_parse_value),
+		cmocka_unit_test(test_apply_value),
+		cmocka_unit_test(test_apply_value_wrap),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,109 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include "src/latency.h"
+
+void
+test_empty_histogram(void **state)
+{
+	(void) state;
+
+	struct wob_latency_histogram histogram = {0};
+	assert_int_equal(wob_latency_histogram_percentile(&histogram, 0.5), 0);
+	assert_int_equal(wob_latency_histogram_percentile(&histogram, 0.99), 0);
+}
+
+void
+test_small_values_are_exact(void **state)
+{
+	(void) state;
+
+	struct wob_latency_histogram histogram = {0};
+	for (uint64_t i = 0; i < 8; ++i) {
+		wob_latency_histogram_add(&histogram, i);
+	}
+
+	assert_int_equal(histogram.count, 8);
+	assert_int_equal(histogram.max_usec, 7);
+	assert_int_equal(wob_latency_histogram_percentile(&histogram, 0.5), 3);
+	assert_int_equal(wob_latency_histogram_percentile(&histogram, 1.0), 7);
+}
+
+void
+test_percentile_error_is_bounded(void **state)
+{
+	(void) state;
+
+	struct wob_latency_histogram histogram = {0};
+	for (uint64_t i = 1; i <= 100000; ++i) {
+		wob_latency_histogram_add(&histogram, i);
+	}
+
+	uint64_t p50 = wob_latency_histogram_percentile(&histogram, 0.5);
+	uint64_t p99 = wob_latency_histogram_percentile(&histogram, 0.99);
+	assert_in_range(p50, 50000, 50000 + 50000 / 8);
+	assert_in_range(p99, 99000, 100000);
+	assert_int_equal(wob_latency_histogram_percentile(&histogram, 1.0), 100000);
+}
+
+void
+test_huge_value_is_clamped(void **state)
+{
+	(void) state;
+
+	struct wob_latency_histogram histogram = {0};
+	wob_latency_histogram_add(&histogram, UINT64_MAX);
+
+	assert_int_equal(histogram.count, 1);
+	assert_true(wob_latency_histogram_percentile(&histogram, 0.5) == UINT64_MAX);
+}
+
+void
+test_frame_is_split_into_stages(void **state)
+{
+	(void) state;
+
+	struct wob_latency latency = {0};
+	struct wob_frame_timing timing = {
+		.input = {.tv_sec = 10, .tv_nsec = 999000000},
+		.render_start = {.tv_sec = 11, .tv_nsec = 0},
+		.render_end = {.tv_sec = 11, .tv_nsec = 5000},
+		.commit = {.tv_sec = 11, .tv_nsec = 6000},
+	};
+	struct timespec presented = {.tv_sec = 11, .tv_nsec = 7000};
+	wob_latency_record_presented(&latency, &timing, presented);
+
+	assert_int_equal(latency.stages[WOB_LATENCY_INPUT_TO_COMMIT].max_usec, 1006);
+	assert_int_equal(latency.stages[WOB_LATENCY_RENDER].max_usec, 5);
+	assert_int_equal(latency.stages[WOB_LATENCY_COMMIT_TO_PRESENT].max_usec, 1);
+	assert_int_equal(latency.stages[WOB_LATENCY_INPUT_TO_PRESENT].max_usec, 1007);
+}
+
+void
+test_clock_going_backwards_is_zero(void **state)
+{
+	(void) state;
+
+	struct timespec from = {.tv_sec = 2, .tv_nsec = 0};
+	struct timespec to = {.tv_sec = 1, .tv_nsec = 0};
+	assert_int_equal(wob_latency_elapsed_usec(from, to), 0);
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_empty_histogram),
+		cmocka_unit_test(test_small_values_are_exact),
+		cmocka_unit_test(test_percentile_error_is_bounded),
+		cmocka_unit_test(test_huge_value_is_clamped),
+		cmocka_unit_test(test_frame_is_split_into_stages),
+		cmocka_unit_test(test_clock_going_backwards_is_zero),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
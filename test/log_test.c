@@ -0,0 +1,283 @@
+#include <fcntl.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "src/log.h"
+
+#define WOB_FILE "log_test.c"
+
+// ring tests call wob_log() directly, wob_log_info() and friends may be compiled out by the log_level option
+
+struct captured_stderr {
+	int saved_fd;
+	int read_fd;
+	char data[2 * WOB_LOG_RING_SIZE];
+	size_t length;
+};
+
+int
+setup(void **state)
+{
+	struct captured_stderr *captured = calloc(1, sizeof(struct captured_stderr));
+	int fds[2];
+	if (captured == NULL || pipe(fds) != 0) {
+		free(captured);
+		return -1;
+	}
+
+	// pipe has to hold everything the tests log, default capacity is 64 KiB
+	captured->saved_fd = dup(STDERR_FILENO);
+	captured->read_fd = fds[0];
+	fcntl(captured->read_fd, F_SETFL, O_NONBLOCK);
+	dup2(fds[1], STDERR_FILENO);
+	close(fds[1]);
+
+	wob_log_use_colors(false);
+	wob_log_level_debug();
+	*state = captured;
+
+	return 0;
+}
+
+int
+teardown(void **state)
+{
+	struct captured_stderr *captured = *state;
+	wob_log_flush();
+	dup2(captured->saved_fd, STDERR_FILENO);
+	close(captured->saved_fd);
+	close(captured->read_fd);
+	free(captured);
+
+	return 0;
+}
+
+size_t
+drain(struct captured_stderr *captured)
+{
+	captured->length = 0;
+	ssize_t ret;
+	while ((ret = read(captured->read_fd, captured->data + captured->length, sizeof(captured->data) - 1 - captured->length)) > 0) {
+		captured->length += ret;
+	}
+	captured->data[captured->length] = '\0';
+
+	return captured->length;
+}
+
+void
+test_records_wait_for_flush(void **state)
+{
+	struct captured_stderr *captured = *state;
+	drain(captured);
+
+	wob_log(WOB_LOG_INFO, WOB_FILE, __LINE__, "first %d", 1);
+	wob_log(WOB_LOG_DEBUG, WOB_FILE, __LINE__, "second %s", "record");
+	assert_int_equal(drain(captured), 0);
+
+	wob_log_flush();
+	drain(captured);
+	assert_non_null(strstr(captured->data, " INFO  log_test.c:"));
+	assert_non_null(strstr(captured->data, ": first 1\n"));
+	assert_non_null(strstr(captured->data, " DEBUG log_test.c:"));
+	assert_non_null(strstr(captured->data, ": second record\n"));
+	assert_true(strstr(captured->data, "first") < strstr(captured->data, "second"));
+
+	// nothing is written twice
+	wob_log_flush();
+	assert_int_equal(drain(captured), 0);
+}
+
+void
+test_errors_are_flushed_immediately(void **state)
+{
+	struct captured_stderr *captured = *state;
+	drain(captured);
+
+	wob_log(WOB_LOG_INFO, WOB_FILE, __LINE__, "queued");
+	wob_log(WOB_LOG_ERROR, WOB_FILE, __LINE__, "failed");
+	drain(captured);
+	assert_non_null(strstr(captured->data, "queued\n"));
+	assert_non_null(strstr(captured->data, "failed\n"));
+}
+
+void
+test_full_ring_keeps_order(void **state)
+{
+	struct captured_stderr *captured = *state;
+	drain(captured);
+
+	// more than fits into the ring, so it is flushed on the way and wraps around
+	const int records = WOB_LOG_RING_SIZE / 32;
+	for (int i = 0; i < records; ++i) {
+		wob_log(WOB_LOG_WARN, WOB_FILE, __LINE__, "record %05d", i);
+	}
+	wob_log_flush();
+	drain(captured);
+
+	const char *cursor = captured->data;
+	for (int i = 0; i < records; ++i) {
+		char expected[32];
+		snprintf(expected, sizeof(expected), ": record %05d\n", i);
+		cursor = strstr(cursor, expected);
+		assert_non_null(cursor);
+	}
+}
+
+void
+test_long_records_are_truncated(void **state)
+{
+	struct captured_stderr *captured = *state;
+	drain(captured);
+
+	char message[2 * WOB_LOG_RECORD_SIZE];
+	memset(message, 'x', sizeof(message) - 1);
+	message[sizeof(message) - 1] = '\0';
+
+	wob_log(WOB_LOG_INFO, WOB_FILE, __LINE__, "%s", message);
+	wob_log(WOB_LOG_INFO, WOB_FILE, __LINE__, "next");
+	wob_log_flush();
+	drain(captured);
+
+	char *newline = strchr(captured->data, '\n');
+	assert_non_null(newline);
+	assert_int_equal(newline - captured->data + 1, WOB_LOG_RECORD_SIZE);
+	assert_non_null(strstr(newline, "next\n"));
+}
+
+void
+test_filtered_arguments_are_not_evaluated(void **state)
+{
+	struct captured_stderr *captured = *state;
+	drain(captured);
+
+	int evaluated = 0;
+	wob_log_level_warn();
+	wob_log_debug("%d", ++evaluated);
+	wob_log_info("%d", ++evaluated);
+	assert_int_equal(evaluated, 0);
+	assert_false(wob_log_enabled(WOB_LOG_INFO));
+
+	wob_log_error("%d", ++evaluated);
+	assert_int_equal(evaluated, 1);
+	assert_true(wob_log_enabled(WOB_LOG_ERROR));
+
+	wob_log_level_debug();
+	wob_log_flush();
+	drain(captured);
+	assert_non_null(strstr(captured->data, " ERROR log_test.c:"));
+	assert_null(strstr(captured->data, " INFO  log_test.c:"));
+}
+
+bool
+contains(const char *data, size_t length, const char *needle, size_t needle_length)
+{
+	for (size_t i = 0; i + needle_length <= length; ++i) {
+		if (memcmp(data + i, needle, needle_length) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+test_journal_records_are_datagrams(void **state)
+{
+	struct captured_stderr *captured = *state;
+	drain(captured);
+
+	// stand-in for the journal socket
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	strcpy(address.sun_path, "/tmp/wob-log-test-XXXXXX");
+	int tmp_fd = mkstemp(address.sun_path);
+	assert_int_not_equal(tmp_fd, -1);
+	close(tmp_fd);
+	unlink(address.sun_path);
+
+	int journal_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	assert_int_not_equal(journal_fd, -1);
+	assert_int_equal(bind(journal_fd, (struct sockaddr *) &address, sizeof(address)), 0);
+	fcntl(journal_fd, F_SETFL, O_NONBLOCK);
+
+	assert_true(wob_log_use_journal(address.sun_path));
+	wob_log_value(WOB_LOG_INFO, WOB_FILE, 42, "+5", "Received %s", "input\nwith newline");
+	wob_log(WOB_LOG_ERROR, WOB_FILE, 43, "failed");
+
+	char datagram[WOB_LOG_RECORD_SIZE + 256];
+	ssize_t length = recv(journal_fd, datagram, sizeof(datagram), 0);
+	assert_true(length > 0);
+	assert_true(contains(datagram, length, "PRIORITY=6\n", strlen("PRIORITY=6\n")));
+	assert_true(contains(datagram, length, "SYSLOG_IDENTIFIER=wob\n", strlen("SYSLOG_IDENTIFIER=wob\n")));
+	assert_true(contains(datagram, length, "CODE_FILE=log_test.c\n", strlen("CODE_FILE=log_test.c\n")));
+	assert_true(contains(datagram, length, "CODE_LINE=42\n", strlen("CODE_LINE=42\n")));
+	const char message[] = "MESSAGE\n\x1b\0\0\0\0\0\0\0Received input\nwith newline\n";
+	assert_true(contains(datagram, length, message, sizeof(message) - 1));
+	const char value[] = "WOB_VALUE\n\x02\0\0\0\0\0\0\0+5\n";
+	assert_true(contains(datagram, length, value, sizeof(value) - 1));
+
+	// one datagram per record, without a value field when there is none
+	length = recv(journal_fd, datagram, sizeof(datagram), 0);
+	assert_true(length > 0);
+	assert_true(contains(datagram, length, "PRIORITY=3\n", strlen("PRIORITY=3\n")));
+	assert_false(contains(datagram, length, "WOB_VALUE", strlen("WOB_VALUE")));
+	assert_int_equal(recv(journal_fd, datagram, sizeof(datagram), 0), -1);
+
+	// nothing reaches stderr, not even the timestamped text
+	wob_log_flush();
+	assert_int_equal(drain(captured), 0);
+
+	// stderr takes over when the journal goes away
+	close(journal_fd);
+	unlink(address.sun_path);
+	wob_log(WOB_LOG_INFO, WOB_FILE, __LINE__, "fallback");
+	wob_log_flush();
+	drain(captured);
+	assert_non_null(strstr(captured->data, ": fallback\n"));
+
+	assert_true(wob_log_use_journal(NULL));
+}
+
+void
+test_journal_stream_is_detected(void **state)
+{
+	struct stat st;
+	assert_int_equal(fstat(STDERR_FILENO, &st), 0);
+
+	char journal_stream[64];
+	snprintf(journal_stream, sizeof(journal_stream), "%llu:%llu", (unsigned long long) st.st_dev, (unsigned long long) st.st_ino);
+	setenv("JOURNAL_STREAM", journal_stream, 1);
+	assert_true(wob_log_is_journal_stream(STDERR_FILENO));
+
+	setenv("JOURNAL_STREAM", "0:0", 1);
+	assert_false(wob_log_is_journal_stream(STDERR_FILENO));
+
+	unsetenv("JOURNAL_STREAM");
+	assert_false(wob_log_is_journal_stream(STDERR_FILENO));
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_records_wait_for_flush),
+		cmocka_unit_test(test_errors_are_flushed_immediately),
+		cmocka_unit_test(test_full_ring_keeps_order),
+		cmocka_unit_test(test_long_records_are_truncated),
+		cmocka_unit_test(test_filtered_arguments_are_not_evaluated),
+		cmocka_unit_test(test_journal_records_are_datagrams),
+		cmocka_unit_test(test_journal_stream_is_detected),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
@@ -0,0 +1,168 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "src/input.h"
+#include "src/server.h"
+
+struct socket_dir {
+	char dir[sizeof("/tmp/wob-server-test-XXXXXX")];
+	char path[sizeof("/tmp/wob-server-test-XXXXXX/wob.sock")];
+};
+
+int
+setup(void **state)
+{
+	struct socket_dir *socket_dir = malloc(sizeof(struct socket_dir));
+	if (socket_dir == NULL) {
+		return -1;
+	}
+
+	strcpy(socket_dir->dir, "/tmp/wob-server-test-XXXXXX");
+	if (mkdtemp(socket_dir->dir) == NULL) {
+		free(socket_dir);
+		return -1;
+	}
+	snprintf(socket_dir->path, sizeof(socket_dir->path), "%s/wob.sock", socket_dir->dir);
+	*state = socket_dir;
+
+	return 0;
+}
+
+int
+teardown(void **state)
+{
+	struct socket_dir *socket_dir = *state;
+	unlink(socket_dir->path);
+	rmdir(socket_dir->dir);
+	free(socket_dir);
+
+	return 0;
+}
+
+int
+connect_client(const char *path)
+{
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	strcpy(address.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert_int_not_equal(fd, -1);
+	assert_int_equal(connect(fd, (struct sockaddr *) &address, sizeof(address)), 0);
+
+	return fd;
+}
+
+void
+test_concurrent_clients_keep_their_lines(void **state)
+{
+	struct socket_dir *socket_dir = *state;
+	int listen_fd = wob_server_listen(socket_dir->path);
+	assert_int_not_equal(listen_fd, -1);
+
+	struct wob_server server;
+	wob_server_init(&server, listen_fd);
+
+	int first = connect_client(socket_dir->path);
+	int second = connect_client(socket_dir->path);
+	assert_non_null(wob_server_accept(&server));
+	assert_non_null(wob_server_accept(&server));
+	assert_int_equal(server.clients_count, 2);
+
+	// interleaved partial writes must not mix values of different producers
+	assert_int_equal(write(first, "1", 1), 1);
+	assert_int_equal(write(second, "2", 1), 1);
+	assert_int_equal(write(first, "0\n", 2), 2);
+	assert_int_equal(write(second, "0 style\n", 8), 8);
+
+	assert_int_equal(wob_input_read(server.clients[0]), 3);
+	assert_string_equal(wob_input_next_line(server.clients[0]), "10");
+	assert_int_equal(wob_input_read(server.clients[1]), 9);
+	assert_string_equal(wob_input_next_line(server.clients[1]), "20 style");
+
+	close(first);
+	struct wob_input *freed = server.clients[0];
+	assert_int_equal(wob_input_read(server.clients[0]), 0);
+	wob_server_close_client(&server, 0);
+	assert_int_equal(server.clients_count, 1);
+
+	// second client took the freed slot
+	assert_int_equal(write(second, "30\n", 3), 3);
+	assert_int_equal(wob_input_read(server.clients[0]), 3);
+	assert_string_equal(wob_input_next_line(server.clients[0]), "30");
+
+	// slots are preallocated, a new client reuses the freed one
+	int third = connect_client(socket_dir->path);
+	assert_ptr_equal(wob_server_accept(&server), freed);
+	assert_int_equal(server.clients_count, 2);
+
+	close(third);
+	close(second);
+	wob_server_destroy(&server);
+}
+
+void
+test_accept_without_pending_connection(void **state)
+{
+	struct socket_dir *socket_dir = *state;
+	int listen_fd = wob_server_listen(socket_dir->path);
+	assert_int_not_equal(listen_fd, -1);
+
+	struct wob_server server;
+	wob_server_init(&server, listen_fd);
+
+	// listener is non-blocking, nothing to accept must not hang
+	assert_null(wob_server_accept(&server));
+	assert_int_equal(server.clients_count, 0);
+
+	wob_server_destroy(&server);
+}
+
+void
+test_stale_socket_is_replaced(void **state)
+{
+	struct socket_dir *socket_dir = *state;
+	int listen_fd = wob_server_listen(socket_dir->path);
+	assert_int_not_equal(listen_fd, -1);
+
+	// socket still in use by another wob is left alone
+	assert_int_equal(wob_server_listen(socket_dir->path), -1);
+
+	close(listen_fd);
+	listen_fd = wob_server_listen(socket_dir->path);
+	assert_int_not_equal(listen_fd, -1);
+
+	close(listen_fd);
+}
+
+void
+test_path_too_long(void **state)
+{
+	char path[sizeof(((struct sockaddr_un *) NULL)->sun_path) + 1];
+	memset(path, 'a', sizeof(path) - 1);
+	path[sizeof(path) - 1] = '\0';
+
+	assert_int_equal(wob_server_listen(path), -1);
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_concurrent_clients_keep_their_lines, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_accept_without_pending_connection, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_stale_socket_is_replaced, setup, teardown),
+		cmocka_unit_test(test_path_too_long),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,82 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "global_configuration.h"
+#include "src/shm.h"
+
+void
+test_grow_keeps_content(void **state)
+{
+	(void) state;
+
+	struct wob_shm shm;
+	assert_true(wob_shm_open(&shm));
+
+	assert_true(wob_shm_reserve(&shm, 4096));
+	assert_int_equal(shm.size, 4096);
+	memset(shm.data, 0xAB, shm.size);
+
+	assert_true(wob_shm_reserve(&shm, 1 << 20));
+	assert_int_equal(shm.size, 1 << 20);
+	for (size_t i = 0; i < 4096; ++i) {
+		assert_int_equal(((unsigned char *) shm.data)[i], 0xAB);
+	}
+	// new tail is zero filled
+	assert_int_equal(((unsigned char *) shm.data)[shm.size - 1], 0);
+
+	wob_shm_close(&shm);
+	assert_int_equal(shm.fd, -1);
+}
+
+void
+test_smaller_size_reuses_mapping(void **state)
+{
+	(void) state;
+
+	struct wob_shm shm;
+	assert_true(wob_shm_open(&shm));
+
+	assert_true(wob_shm_reserve(&shm, 65536));
+	void *data = shm.data;
+
+	assert_true(wob_shm_reserve(&shm, 4096));
+	assert_ptr_equal(shm.data, data);
+	assert_int_equal(shm.size, 65536);
+
+	wob_shm_close(&shm);
+}
+
+#ifdef WOB_HAVE_MEMFD
+void
+test_shm_cannot_shrink(void **state)
+{
+	(void) state;
+
+	struct wob_shm shm;
+	assert_true(wob_shm_open(&shm));
+	assert_true(wob_shm_reserve(&shm, 65536));
+
+	assert_int_not_equal(ftruncate(shm.fd, 4096), 0);
+
+	wob_shm_close(&shm);
+}
+#endif
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_grow_keeps_content),
+		cmocka_unit_test(test_smaller_size_reuses_mapping),
+#ifdef WOB_HAVE_MEMFD
+		cmocka_unit_test(test_shm_cannot_shrink),
+#endif
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
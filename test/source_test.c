@@ -0,0 +1,173 @@
+#include <fcntl.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "src/source.h"
+
+struct source_files {
+	char dir[sizeof("/tmp/wob-source-test-XXXXXX")];
+	char value_path[sizeof("/tmp/wob-source-test-XXXXXX/brightness")];
+	char max_path[sizeof("/tmp/wob-source-test-XXXXXX/max_brightness")];
+	struct wob_source_config config;
+	int watch_fd;
+};
+
+void
+write_file(const char *path, const char *content)
+{
+	// same as `echo 10 > brightness`, truncate and write in place
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	assert_int_not_equal(fd, -1);
+	assert_int_equal(write(fd, content, strlen(content)), strlen(content));
+	close(fd);
+}
+
+int
+setup(void **state)
+{
+	struct source_files *files = calloc(1, sizeof(struct source_files));
+	if (files == NULL) {
+		return -1;
+	}
+
+	strcpy(files->dir, "/tmp/wob-source-test-XXXXXX");
+	if (mkdtemp(files->dir) == NULL) {
+		free(files);
+		return -1;
+	}
+	snprintf(files->value_path, sizeof(files->value_path), "%s/brightness", files->dir);
+	snprintf(files->max_path, sizeof(files->max_path), "%s/max_brightness", files->dir);
+	write_file(files->value_path, "30\n");
+	write_file(files->max_path, "255\n");
+
+	files->config.id = "backlight";
+	files->config.path = files->value_path;
+	files->config.max_path = files->max_path;
+	files->watch_fd = wob_source_watch_create();
+	if (files->watch_fd == -1) {
+		return -1;
+	}
+	*state = files;
+
+	return 0;
+}
+
+int
+teardown(void **state)
+{
+	struct source_files *files = *state;
+	close(files->watch_fd);
+	unlink(files->value_path);
+	unlink(files->max_path);
+	rmdir(files->dir);
+	free(files);
+
+	return 0;
+}
+
+void
+test_initial_value_and_max(void **state)
+{
+	struct source_files *files = *state;
+	struct wob_source source;
+
+	assert_true(wob_source_open(&source, &files->config, files->watch_fd, 100));
+	assert_int_equal(source.value, 30);
+	assert_int_equal(source.max, 255);
+	assert_false(source.dirty);
+
+	wob_source_close(&source);
+}
+
+void
+test_default_max_without_max_path(void **state)
+{
+	struct source_files *files = *state;
+	struct wob_source source;
+
+	files->config.max_path = NULL;
+	assert_true(wob_source_open(&source, &files->config, files->watch_fd, 100));
+	assert_int_equal(source.max, 100);
+
+	wob_source_close(&source);
+}
+
+void
+test_invalid_max_fails(void **state)
+{
+	struct source_files *files = *state;
+	struct wob_source source;
+
+	write_file(files->max_path, "0\n");
+	assert_false(wob_source_open(&source, &files->config, files->watch_fd, 100));
+
+	unlink(files->max_path);
+	assert_false(wob_source_open(&source, &files->config, files->watch_fd, 100));
+}
+
+void
+test_change_is_reported(void **state)
+{
+	struct source_files *files = *state;
+	struct wob_source source;
+	assert_true(wob_source_open(&source, &files->config, files->watch_fd, 100));
+
+	write_file(files->value_path, "40\n");
+	wob_source_watch_dispatch(files->watch_fd, &source, 1);
+	assert_true(source.dirty);
+	assert_true(wob_source_read(&source));
+	assert_false(source.dirty);
+	assert_int_equal(source.value, 40);
+
+	// rewriting the same value is not a change
+	write_file(files->value_path, "40\n");
+	wob_source_watch_dispatch(files->watch_fd, &source, 1);
+	assert_true(source.dirty);
+	assert_false(wob_source_read(&source));
+
+	// nothing written, nothing to dispatch
+	wob_source_watch_dispatch(files->watch_fd, &source, 1);
+	assert_false(source.dirty);
+
+	wob_source_close(&source);
+}
+
+void
+test_empty_file_keeps_value(void **state)
+{
+	struct source_files *files = *state;
+	struct wob_source source;
+	assert_true(wob_source_open(&source, &files->config, files->watch_fd, 100));
+
+	// read between truncation and write of a new value
+	write_file(files->value_path, "");
+	assert_false(wob_source_read(&source));
+	assert_int_equal(source.value, 30);
+
+	write_file(files->value_path, "abc\n");
+	assert_false(wob_source_read(&source));
+	assert_int_equal(source.value, 30);
+
+	wob_source_close(&source);
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_initial_value_and_max, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_default_max_without_max_path, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_invalid_max_fails, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_change_is_reported, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_empty_file_keeps_value, setup, teardown),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,321 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "compositor.h"
+#include "src/config.h"
+#include "src/image.h"
+
+#define WOB_BENCHMARK_MAX 100
+// how long to wait for the last value to show up after the flood stopped
+#define WOB_BENCHMARK_SETTLE_MSEC 500
+// lost frame callback or a stuck wob fails the benchmark after this long instead of hanging it
+#define WOB_BENCHMARK_TIMEOUT_SEC 10.0
+
+static const struct wob_dimensions dimensions = {
+	.width = 400,
+	.height = 50,
+	.border_offset = 4,
+	.border_size = 4,
+	.bar_padding = 4,
+	.orientation = WOB_ORIENTATION_HORIZONTAL,
+};
+
+static const char config[] =
+	"timeout = 10000\n"
+	"max = 100\n"
+	"width = 400\n"
+	"height = 50\n"
+	"border_offset = 4\n"
+	"border_size = 4\n"
+	"bar_padding = 4\n"
+	"background_color = 000000\n"
+	"border_color = FFFFFF\n"
+	"bar_color = FFFFFF\n";
+
+struct flood {
+	struct wob_test_compositor *compositor;
+	struct wl_event_source *timer;
+	int fd;
+	unsigned long rate;
+	double duration;
+
+	bool started;
+	struct timespec start;
+	unsigned long written;
+	// lines that did not fit into the pipe because wob didn't drain it fast enough
+	unsigned long dropped;
+	unsigned long last_value;
+	// commits and frame callbacks when the flood started, startup is not part of the numbers
+	unsigned long start_commits;
+	unsigned long start_frame_callbacks;
+	uint64_t start_damaged_pixels;
+	unsigned long commits;
+	unsigned long frame_callbacks;
+	uint64_t damaged_pixels;
+
+	bool flooding;
+	bool settled;
+};
+
+double
+elapsed_sec(struct timespec from)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double) (now.tv_sec - from.tv_sec) + (double) (now.tv_nsec - from.tv_nsec) / 1e9;
+}
+
+bool
+write_lines(struct flood *flood, unsigned long count)
+{
+	// writes of at most PIPE_BUF bytes are atomic, so a line is never split by a full pipe
+	char buffer[PIPE_BUF];
+	while (count > 0) {
+		size_t length = 0;
+		unsigned long lines = 0;
+		unsigned long value = flood->last_value;
+		while (lines < count && length + sizeof("100\n") <= sizeof(buffer)) {
+			value = (flood->written + flood->dropped + lines) % (WOB_BENCHMARK_MAX + 1);
+			length += snprintf(buffer + length, sizeof(buffer) - length, "%lu\n", value);
+			lines += 1;
+		}
+
+		ssize_t ret = write(flood->fd, buffer, length);
+		if (ret == -1 && errno == EAGAIN) {
+			flood->dropped += lines;
+		}
+		else if (ret == -1) {
+			fprintf(stderr, "write() failed: %s\n", strerror(errno));
+			return false;
+		}
+		else {
+			flood->written += lines;
+			flood->last_value = value;
+		}
+
+		count -= lines;
+	}
+
+	return true;
+}
+
+int
+flood_tick(void *data)
+{
+	struct flood *flood = data;
+	struct wob_test_compositor_stats *stats = &flood->compositor->stats;
+
+	// first value creates the surface, flood starts once it is mapped with its real size
+	if (!flood->started) {
+		if (stats->buffer_width != dimensions.width || stats->buffer_height != dimensions.height) {
+			wl_event_source_timer_update(flood->timer, 1);
+			return 0;
+		}
+
+		flood->started = true;
+		flood->flooding = true;
+		flood->start_commits = stats->buffer_commits;
+		flood->start_frame_callbacks = stats->frame_callbacks;
+		flood->start_damaged_pixels = stats->damaged_pixels;
+		clock_gettime(CLOCK_MONOTONIC, &flood->start);
+	}
+
+	double elapsed = elapsed_sec(flood->start);
+	if (flood->flooding) {
+		if (elapsed >= flood->duration) {
+			flood->flooding = false;
+			flood->commits = stats->buffer_commits - flood->start_commits;
+			flood->frame_callbacks = stats->frame_callbacks - flood->start_frame_callbacks;
+			flood->damaged_pixels = stats->damaged_pixels - flood->start_damaged_pixels;
+			wl_event_source_timer_update(flood->timer, WOB_BENCHMARK_SETTLE_MSEC);
+			return 0;
+		}
+
+		unsigned long due = (unsigned long) (elapsed * flood->rate);
+		if (due > flood->written + flood->dropped && !write_lines(flood, due - flood->written - flood->dropped)) {
+			flood->flooding = false;
+			flood->settled = true;
+			return 0;
+		}
+
+		wl_event_source_timer_update(flood->timer, 1);
+		return 0;
+	}
+
+	flood->settled = true;
+	return 0;
+}
+
+bool
+last_value_shown(struct flood *flood)
+{
+	struct wob_test_compositor_stats *stats = &flood->compositor->stats;
+	if (stats->buffer == NULL || stats->buffer_width != dimensions.width || stats->buffer_height != dimensions.height) {
+		return false;
+	}
+
+	struct wob_colors colors = {
+		.background = {.a = 1.0f, .r = 0.0f, .g = 0.0f, .b = 0.0f},
+		.border = {.a = 1.0f, .r = 1.0f, .g = 1.0f, .b = 1.0f},
+		.value = {.a = 1.0f, .r = 1.0f, .g = 1.0f, .b = 1.0f},
+	};
+	wob_colors_pack(&colors);
+
+	uint32_t *expected = calloc(dimensions.width * dimensions.height, sizeof(uint32_t));
+	if (expected == NULL) {
+		return false;
+	}
+
+	// every configured color is opaque, so wob draws xrgb8888
+	wob_image_draw(expected, dimensions, WOB_PIXEL_FORMAT_XRGB8888, colors.packed[WOB_PIXEL_FORMAT_XRGB8888], (double) flood->last_value / WOB_BENCHMARK_MAX);
+	bool equal = memcmp(expected, stats->buffer, dimensions.width * dimensions.height * sizeof(uint32_t)) == 0;
+	free(expected);
+
+	return equal;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <wob> [duration seconds] [lines per second]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	struct flood flood = {
+		.duration = argc > 2 ? strtod(argv[2], NULL) : 5.0,
+		.rate = argc > 3 ? strtoul(argv[3], NULL, 10) : 10000,
+	};
+
+	signal(SIGPIPE, SIG_IGN);
+
+	// keep the socket and config away from the running session
+	char runtime_dir[] = "/tmp/wob-benchmark-XXXXXX";
+	if (mkdtemp(runtime_dir) == NULL) {
+		fprintf(stderr, "mkdtemp() failed: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	setenv("XDG_RUNTIME_DIR", runtime_dir, 1);
+
+	char config_path[sizeof(runtime_dir) + sizeof("/wob.ini")];
+	snprintf(config_path, sizeof(config_path), "%s/wob.ini", runtime_dir);
+	FILE *config_file = fopen(config_path, "w");
+	if (config_file == NULL || fputs(config, config_file) == EOF || fclose(config_file) != 0) {
+		fprintf(stderr, "failed to write %s\n", config_path);
+		return EXIT_FAILURE;
+	}
+
+	flood.compositor = wob_test_compositor_create();
+	if (flood.compositor == NULL) {
+		fprintf(stderr, "wob_test_compositor_create() failed\n");
+		return EXIT_FAILURE;
+	}
+	setenv("WAYLAND_DISPLAY", flood.compositor->socket, 1);
+
+	int fds[2];
+	if (pipe(fds) != 0) {
+		fprintf(stderr, "pipe() failed: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	pid_t pid = fork();
+	if (pid == -1) {
+		fprintf(stderr, "fork() failed: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (pid == 0) {
+		dup2(fds[0], STDIN_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		execl(argv[1], argv[1], "-c", config_path, (char *) NULL);
+		fprintf(stderr, "execl(%s) failed: %s\n", argv[1], strerror(errno));
+		_exit(127);
+	}
+
+	close(fds[0]);
+	flood.fd = fds[1];
+	fcntl(flood.fd, F_SETFL, fcntl(flood.fd, F_GETFL) | O_NONBLOCK);
+	if (!write_lines(&flood, 1)) {
+		return EXIT_FAILURE;
+	}
+	flood.written = 0;
+
+	flood.timer = wl_event_loop_add_timer(flood.compositor->wl_event_loop, flood_tick, &flood);
+	wl_event_source_timer_update(flood.timer, 1);
+
+	int status = 0;
+	bool exited = false;
+	bool timed_out = false;
+	struct timespec loop_start;
+	clock_gettime(CLOCK_MONOTONIC, &loop_start);
+	while (!flood.settled) {
+		wl_display_flush_clients(flood.compositor->wl_display);
+		wl_event_loop_dispatch(flood.compositor->wl_event_loop, 10);
+
+		if (waitpid(pid, &status, WNOHANG) == pid) {
+			exited = true;
+			break;
+		}
+		if (elapsed_sec(loop_start) > flood.duration + WOB_BENCHMARK_TIMEOUT_SEC) {
+			fprintf(stderr, "wob did not show up or the flood never settled\n");
+			timed_out = true;
+			break;
+		}
+	}
+
+	bool shown = !timed_out && last_value_shown(&flood);
+
+	// EOF makes wob exit, it's killed when it doesn't
+	close(flood.fd);
+	clock_gettime(CLOCK_MONOTONIC, &loop_start);
+	while (!exited) {
+		wl_display_flush_clients(flood.compositor->wl_display);
+		wl_event_loop_dispatch(flood.compositor->wl_event_loop, 10);
+
+		if (waitpid(pid, &status, WNOHANG) == pid) {
+			exited = true;
+		}
+		else if (elapsed_sec(loop_start) > WOB_BENCHMARK_TIMEOUT_SEC) {
+			fprintf(stderr, "wob did not exit on EOF\n");
+			kill(pid, SIGKILL);
+			waitpid(pid, &status, 0);
+			exited = true;
+		}
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_CHILDREN, &usage);
+	double user_sec = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+	double system_sec = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+
+	printf("wob flooded for %.1f s at %lu lines/s\n", flood.duration, flood.rate);
+	printf("  lines written    %lu\n", flood.written);
+	printf("  dropped inputs   %lu (pipe full)\n", flood.dropped);
+	printf("  commits          %lu (%.1f/s)\n", flood.commits, flood.commits / flood.duration);
+	printf("  frame callbacks  %lu\n", flood.frame_callbacks);
+	printf("  damaged pixels   %.0f per commit\n", flood.commits > 0 ? (double) flood.damaged_pixels / flood.commits : 0.0);
+	printf("  wob CPU time     user %.3f s, system %.3f s (%.1f %% of one core)\n", user_sec, system_sec, 100.0 * (user_sec + system_sec) / flood.duration);
+	printf("  last value shown %s\n", shown ? "yes" : "no");
+
+	wob_test_compositor_destroy(flood.compositor);
+	unlink(config_path);
+	rmdir(runtime_dir);
+
+	if (!shown || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+		fprintf(stderr, "wob did not show the last value or exited with failure\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
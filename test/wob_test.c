@@ -0,0 +1,378 @@
+#include <errno.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "compositor.h"
+#include "src/config.h"
+#include "src/image.h"
+
+// how long wob gets to show a value or to exit
+#define WOB_TEST_TIMEOUT_MSEC 5000
+
+static const struct wob_dimensions dimensions = {
+	.width = 400,
+	.height = 50,
+	.border_offset = 4,
+	.border_size = 4,
+	.bar_padding = 4,
+	.orientation = WOB_ORIENTATION_HORIZONTAL,
+};
+
+#define CONFIG \
+	"timeout = 10000\n" \
+	"max = 100\n" \
+	"width = 400\n" \
+	"height = 50\n" \
+	"border_offset = 4\n" \
+	"border_size = 4\n" \
+	"bar_padding = 4\n" \
+	"background_color = 000000\n" \
+	"border_color = FFFFFF\n" \
+	"bar_color = FFFFFF\n" \
+	"output_mode = all\n"
+
+struct wob_process {
+	char runtime_dir[sizeof("/tmp/wob-test-XXXXXX")];
+	char config_path[sizeof("/tmp/wob-test-XXXXXX/wob.ini")];
+	struct wob_test_compositor *compositor;
+	pid_t pid;
+	int fd;
+};
+
+static char *wob_path;
+
+int
+setup(void **state)
+{
+	struct wob_process *process = calloc(1, sizeof(struct wob_process));
+	if (process == NULL) {
+		return -1;
+	}
+
+	// keep the socket and config away from the running session
+	strcpy(process->runtime_dir, "/tmp/wob-test-XXXXXX");
+	if (mkdtemp(process->runtime_dir) == NULL) {
+		free(process);
+		return -1;
+	}
+	setenv("XDG_RUNTIME_DIR", process->runtime_dir, 1);
+	snprintf(process->config_path, sizeof(process->config_path), "%s/wob.ini", process->runtime_dir);
+
+	process->compositor = wob_test_compositor_create();
+	if (process->compositor == NULL) {
+		rmdir(process->runtime_dir);
+		free(process);
+		return -1;
+	}
+	setenv("WAYLAND_DISPLAY", process->compositor->socket, 1);
+
+	process->pid = -1;
+	process->fd = -1;
+	*state = process;
+
+	return 0;
+}
+
+uint32_t
+elapsed_msec(struct timespec from)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - from.tv_sec) * 1000 + (now.tv_nsec - from.tv_nsec) / 1000000;
+}
+
+int
+teardown(void **state)
+{
+	struct wob_process *process = *state;
+
+	// EOF makes wob exit, it's killed when it doesn't
+	int status = 0;
+	if (process->fd != -1) {
+		close(process->fd);
+	}
+	if (process->pid != -1) {
+		struct timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		while (waitpid(process->pid, &status, WNOHANG) != process->pid) {
+			if (elapsed_msec(start) > WOB_TEST_TIMEOUT_MSEC) {
+				kill(process->pid, SIGKILL);
+				waitpid(process->pid, &status, 0);
+				break;
+			}
+
+			wl_display_flush_clients(process->compositor->wl_display);
+			wl_event_loop_dispatch(process->compositor->wl_event_loop, 10);
+		}
+	}
+
+	wob_test_compositor_destroy(process->compositor);
+	unlink(process->config_path);
+	rmdir(process->runtime_dir);
+	free(process);
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS ? 0 : -1;
+}
+
+void
+start_wob(struct wob_process *process, const char *config)
+{
+	FILE *config_file = fopen(process->config_path, "w");
+	assert_non_null(config_file);
+	assert_int_not_equal(fputs(config, config_file), EOF);
+	assert_int_equal(fclose(config_file), 0);
+
+	int fds[2];
+	assert_int_equal(pipe(fds), 0);
+
+	process->pid = fork();
+	assert_int_not_equal(process->pid, -1);
+	if (process->pid == 0) {
+		dup2(fds[0], STDIN_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		execl(wob_path, wob_path, "-c", process->config_path, (char *) NULL);
+		fprintf(stderr, "execl(%s) failed: %s\n", wob_path, strerror(errno));
+		_exit(127);
+	}
+
+	close(fds[0]);
+	process->fd = fds[1];
+}
+
+bool
+surface_shows_value(struct wob_test_compositor_surface_stats *surface, unsigned long value)
+{
+	if (surface->buffer == NULL || surface->buffer_width < 2 || surface->buffer_height < 2) {
+		return false;
+	}
+
+	struct wob_colors colors = {
+		.background = {.a = 1.0f, .r = 0.0f, .g = 0.0f, .b = 0.0f},
+		.border = {.a = 1.0f, .r = 1.0f, .g = 1.0f, .b = 1.0f},
+		.value = {.a = 1.0f, .r = 1.0f, .g = 1.0f, .b = 1.0f},
+	};
+	wob_colors_pack(&colors);
+
+	struct wob_dimensions surface_dimensions = dimensions;
+	surface_dimensions.width = surface->buffer_width;
+	surface_dimensions.height = surface->buffer_height;
+
+	uint32_t *expected = calloc(surface_dimensions.width * surface_dimensions.height, sizeof(uint32_t));
+	if (expected == NULL) {
+		return false;
+	}
+
+	// every configured color is opaque, so wob draws xrgb8888
+	wob_image_draw(expected, surface_dimensions, WOB_PIXEL_FORMAT_XRGB8888, colors.packed[WOB_PIXEL_FORMAT_XRGB8888], (double) value / 100);
+	bool equal = memcmp(expected, surface->buffer, surface_dimensions.width * surface_dimensions.height * sizeof(uint32_t)) == 0;
+	free(expected);
+
+	return equal;
+}
+
+struct wob_test_compositor_surface_stats *
+find_surface(struct wob_test_compositor_stats *stats, const char *output_name)
+{
+	for (size_t i = 0; i < stats->surfaces_count; ++i) {
+		if (stats->surfaces[i].output_name != NULL && strcmp(stats->surfaces[i].output_name, output_name) == 0) {
+			return &stats->surfaces[i];
+		}
+	}
+
+	return NULL;
+}
+
+void
+dispatch(struct wob_process *process, uint32_t msec)
+{
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (elapsed_msec(start) < msec) {
+		wl_display_flush_clients(process->compositor->wl_display);
+		wl_event_loop_dispatch(process->compositor->wl_event_loop, 10);
+	}
+}
+
+bool
+write_value(struct wob_process *process, unsigned long value)
+{
+	char line[16];
+	int length = snprintf(line, sizeof(line), "%lu\n", value);
+
+	return write(process->fd, line, length) == length;
+}
+
+bool
+show_value(struct wob_process *process, unsigned long value)
+{
+	if (!write_value(process, value)) {
+		return false;
+	}
+
+	struct wob_test_compositor_stats *stats = &process->compositor->stats;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (elapsed_msec(start) < WOB_TEST_TIMEOUT_MSEC) {
+		wl_display_flush_clients(process->compositor->wl_display);
+		wl_event_loop_dispatch(process->compositor->wl_event_loop, 10);
+
+		if (waitpid(process->pid, NULL, WNOHANG) == process->pid) {
+			process->pid = -1;
+			return false;
+		}
+
+		bool shown = stats->surfaces_count == process->compositor->outputs_count;
+		for (size_t i = 0; i < stats->surfaces_count; ++i) {
+			shown = shown && surface_shows_value(&stats->surfaces[i], value);
+		}
+		if (shown) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+test_same_size_outputs_share_drawn_buffer(void **state)
+{
+	struct wob_process *process = *state;
+	struct wob_test_compositor_stats *stats = &process->compositor->stats;
+	assert_true(wob_test_compositor_add_output(process->compositor));
+	start_wob(process, CONFIG);
+
+	assert_true(show_value(process, 30));
+	assert_int_equal(stats->surfaces_count, 2);
+	struct wob_test_compositor_surface_stats *first = find_surface(stats, "TEST-1");
+	struct wob_test_compositor_surface_stats *second = find_surface(stats, "TEST-2");
+	assert_non_null(first);
+	assert_non_null(second);
+
+	// bar is drawn once, the other surface attaches the very same buffer
+	assert_int_equal(first->buffer_id, second->buffer_id);
+
+	// delta drawn on top of a buffer both surfaces used before
+	assert_true(show_value(process, 70));
+	assert_int_equal(first->buffer_id, second->buffer_id);
+	assert_true(show_value(process, 10));
+	assert_int_equal(first->buffer_id, second->buffer_id);
+}
+
+void
+test_pool_grows_while_buffers_are_live(void **state)
+{
+	struct wob_process *process = *state;
+	struct wob_test_compositor_stats *stats = &process->compositor->stats;
+
+	static const char config[] = CONFIG
+		"[output.big]\n"
+		"match = TEST-2\n"
+		"width = 1200\n"
+		"height = 300\n";
+	start_wob(process, config);
+
+	assert_true(show_value(process, 30));
+	assert_int_equal(stats->surfaces_count, 1);
+
+	// output connected while the first surface holds drawn buffers, wob binds it and creates its surface on the next input
+	assert_true(wob_test_compositor_add_output(process->compositor));
+	dispatch(process, 200);
+	assert_int_equal(wl_list_length(&process->compositor->output_resources), 2);
+
+	// its bigger pool is carved out of the same shm, which grows and may move under the first pool
+	assert_true(show_value(process, 70));
+	struct wob_test_compositor_surface_stats *first = find_surface(stats, "TEST-1");
+	struct wob_test_compositor_surface_stats *second = find_surface(stats, "TEST-2");
+	assert_non_null(first);
+	assert_non_null(second);
+	assert_int_equal(first->buffer_width, 400);
+	assert_int_equal(first->buffer_height, 50);
+	assert_int_equal(second->buffer_width, 1200);
+	assert_int_equal(second->buffer_height, 300);
+	assert_int_not_equal(first->buffer_id, second->buffer_id);
+
+	// first pool keeps drawing deltas into its buffers at their new address
+	assert_true(show_value(process, 0));
+	assert_true(show_value(process, 100));
+}
+
+void
+test_busy_buffers_are_not_overwritten(void **state)
+{
+	struct wob_process *process = *state;
+	struct wob_test_compositor_stats *stats = &process->compositor->stats;
+
+	// every buffer stays busy for longer than a frame, so wob runs out of them and has to postpone frames
+	process->compositor->hold_buffer_frames = 4;
+	start_wob(process, CONFIG);
+	assert_true(show_value(process, 0));
+
+	// new value every frame
+	for (unsigned long i = 1; i <= 60; ++i) {
+		assert_true(write_value(process, i * 37 % 101));
+		dispatch(process, WOB_TEST_COMPOSITOR_REFRESH_MSEC);
+	}
+	assert_true(show_value(process, 50));
+
+	// all three buffers were in use at once and none of them was written while the compositor held it
+	assert_int_equal(stats->held_buffers_max, 3);
+	assert_int_equal(stats->busy_overwrites, 0);
+}
+
+void
+test_busy_buffers_keep_their_range(void **state)
+{
+	struct wob_process *process = *state;
+	struct wob_test_compositor_stats *stats = &process->compositor->stats;
+
+	// buffers of the old size are still held for a while after the surface got its new size
+	process->compositor->hold_buffer_frames = 30;
+	start_wob(process, CONFIG);
+	assert_true(show_value(process, 30));
+	assert_int_equal(stats->surfaces[0].buffer_width, 400);
+
+	// bigger pool replaces the old one while its buffer is held and is drawn right away
+	wob_test_compositor_set_scale(process->compositor, 240);
+	dispatch(process, 200);
+	assert_int_equal(stats->surfaces[0].buffer_width, 800);
+	assert_int_equal(stats->surfaces[0].buffer_height, 100);
+	assert_true(write_value(process, 70));
+	dispatch(process, 30 * WOB_TEST_COMPOSITOR_REFRESH_MSEC * 2);
+
+	// old range was only handed out again after the compositor released its buffer
+	assert_int_equal(stats->busy_destroys, 0);
+	assert_int_equal(stats->busy_overwrites, 0);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <wob>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	wob_path = argv[1];
+
+	signal(SIGPIPE, SIG_IGN);
+
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_same_size_outputs_share_drawn_buffer, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_pool_grows_while_buffers_are_live, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_busy_buffers_are_not_overwritten, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_busy_buffers_keep_their_range, setup, teardown),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}